@@ -13,21 +13,37 @@
 //==============================================================================
 #define  __MAIN_C
 #include "stm32f_stpdrv.h"
+#include "stm32f_stpcom.h"
+#include "stm32f_stptlm.h"
+#include "stm32f_stpsch.h"
+#include "stm32f_stpenc.h"
+#include "stm32f_stphome.h"
 
+#ifdef STPDRV_USE_ENCODER
+// Encoder de 1000 linhas (4000 contagens) num motor de 200 passos com 16 microsteps
+static const stpenc_cfg_t EncCfg = {4000, 3200, 2, 20, 3, STPENC_ACT_INJECT};
+#endif
+
+#ifdef STPDRV_USE_HOMING
+// Home no interruptor MIN, aproximao a 800 steps/s, recuo de 200 passos e segunda aproximao a 100 steps/s
+static const stphome_cfg_t HomeCfg = {dir_CCW, 800, 100, 200, 0, 0};
+#endif
+
+#ifdef __STM32F4_DISCOVERY_H
 //==============================================================================
-//	descri:   delay em milisegundos SEM CHAMAR Dispatcher
-//	params:	 numero de milisegundos
+//	descri:   tarefa do boto da STM32F4_DISCOVERY
+//	params:	 none
 //	return:	 none
 //
-// Esta rotina foi testada e  exacta para um STM32F4 a 168Mhz
-//
-#define DELAY_ms_LOOP(x) ((SystemCoreClock/4000)*x)  
-void _delay(uint32_t _ms)
-{  
-	uint32_t i = 0;
-	for ( i = DELAY_ms_LOOP(_ms); i; i--) __nop();
+static void _button(void)
+{
+	if (STM32F4_Discovery_PBGetState(BUTTON_USER)==Bit_SET) {
+		STM32F4_Discovery_LEDOn(LED5);
+		STPDRV_Move(MOTOR1, dir_CW, 30);
+	}
 }
 //==============================================================================
+#endif
 
 
 //==============================================================================
@@ -40,6 +56,23 @@ int main(void)
 	
 	// Initialize Stepper Driver Firmware
 	STPDRV_Init();
+	STPSCH_Init();
+	STPCOM_Init();
+	STPTLM_Init();
+	STPTLM_Start(100, (1 << MOTOR1) | (1 << MOTOR2));
+#ifdef STPDRV_USE_ENCODER
+	STPENC_Init();
+	STPENC_Config(MOTOR1, &EncCfg);
+#endif
+#ifdef STPDRV_USE_HOMING
+	STPHOME_Init();
+	STPHOME_Config(MOTOR1, &HomeCfg);
+#endif
+#ifdef STPDRV_USE_MICROSTEP
+	// A4988 com MS1..MS3 nos pinos 0..2: 1/4 acima de 900 steps/s, full step acima de 3000 steps/s
+	STPDRV_SetMicrostep(MOTOR1, 1, 4, GPIO_Pin_1, 900, 700);
+	STPDRV_SetMicrostep(MOTOR1, 2, 16, 0, 3000, 2400);
+#endif
 
 	// STM32F4_DISCOVERY stuf ... if used
 #ifdef __STM32F4_DISCOVERY_H
@@ -53,16 +86,19 @@ int main(void)
 	// Test Stepper Driver
    STPDRV_Move(MOTOR1, dir_CW, 100);
 	
-	while (1) {
-		_delay(1000);
-	
+	// Application tasks, the scheduler idles in WFI between them
+	STPSCH_Add(STPCOM_Poll, 0, 1);
+	STPSCH_Add(STPTLM_Poll, 0, 5);
+#ifdef STPDRV_USE_ENCODER
+	STPSCH_Add(STPENC_Check, 0, 10);
+#endif
+#ifdef STPDRV_USE_HOMING
+	STPSCH_Add(STPHOME_Poll, 0, 5);
+#endif
 #ifdef __STM32F4_DISCOVERY_H
-		if (STM32F4_Discovery_PBGetState(BUTTON_USER)==Bit_SET) {
-			STM32F4_Discovery_LEDOn(LED5);
-			STPDRV_Move(MOTOR1, dir_CW, 30);
-		}
+	STPSCH_Add(_button, 0, 20);
 #endif
-	};
+	STPSCH_Run();
 		
 }
 //==============================================================================
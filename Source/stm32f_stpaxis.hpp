@@ -0,0 +1,335 @@
+/*=============================================================================
+
+	@file    stm32f_stpaxis.hpp
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   Compile-time stepper axis layer (C++) for the STM32F Stepper Driver
+
+   This Software is released under no garanty.
+	You may use this software for personal use.
+	Use for commercial and/or profit applications is strictly prohibited.
+
+  	COPYRIGHT (C) 2026 STM32StepperDriver contributors
+	Partes baseadas no stm32f_stpdrv.c (IRQ do STEP e rampas), COPYRIGHT (C) 2013 Paulo de Almeida
+
+   Compiled under C++11 (ISO/IEC 14882:2011) version
+   please use the "--cpp11" compiler directive
+
+   ===================================================================
+	                    Description (in portuguese)
+   ===================================================================
+	- 	Camada opcional para projectos em C++, o stm32f_stpdrv.c continua em C e não depende dela
+	- 	Cada eixo é um tipo: StepperAxis<Timer, Canal, PinoSTEP, PinoDIR>. Timer, canal, registos,
+		mascaras do BSRR/BRR, do DIER/SR e do RCC são constantes de compilação, o corpo da IRQ
+		de cada eixo é código em linha recta sem testes ao indice do motor
+	- 	Os portos e os timers são dados pelo indice e não pelo endereço (um ponteiro não pode
+		ser parametro de um template): GPIO 0 = GPIOA, 1 = GPIOB, ... e timer 0 = TIM2,
+		1 = TIM3, 2 = TIM4 (indice no APB1). As mascaras do RCC saem do indice, sem a cadeia de
+		if's do __GPIO2AHB1Periph
+	- 	O estado de cada eixo (StpAxisState) é um membro estático do tipo do eixo (AxisN::State),
+		com endereço fixo como os Motors[] do driver. A IRQ faz o mesmo que um canal do STEP do
+		TIM3_IRQHandler do driver: toggle do STEP, contagem da posição no flanco
+		ascendente e inversão do DIR pendente no flanco descendente. Rampas e planeamento ficam
+		a cargo de quem usa (muda CurDelay)
+	- 	Tools/stpaxis.cpp compara, no PC, esta IRQ com a mesma IRQ escrita com macros: estado
+		final, tamanho do código (falha se esta for maior) e tempo por evento (só no x86)
+
+	O mapa dos portos e dos timers é o do STM32F10x. Para outro alvo (ou para o PC) definir
+	STPAXIS_GPIO(n) e STPAXIS_TIM(n) antes de incluir este ficheiro.
+
+
+   ===================================================================
+                       How to use
+   ===================================================================
+	1 - Definir os eixos, por exemplo com os pinos do stm32f_stpdrv.h:
+			typedef StepperAxis<StpTim<1>, 1, StpPin<4, GPIO_Pin_9>,  StpPin<4, GPIO_Pin_10> > Axis1;
+			typedef StepperAxis<StpTim<1>, 2, StpPin<4, GPIO_Pin_11>, StpPin<4, GPIO_Pin_12> > Axis2;
+			typedef StpAxes<Axis1, Axis2> Axes;
+	2 - Chamar Axes::Init() no arranque
+	3 - Na IRQ do timer:
+			extern "C" void TIM3_IRQHandler(void) { Axes::Isr(); }
+	4 - AxisN::Start(...), AxisN::Stop(...) e AxisN::SetDir(...) para mover, mudar
+		AxisN::State.CurDelay para mudar a velocidade
+
+
+   ===================================================================
+                               API
+   ===================================================================
+	StpPin<Port, Pin>
+		static void Set(void), Reset(void)
+				Descri: 	Põe o pino a HIGH (BSRR) ou a LOW (BRR)
+		static bool IsSet(void)
+				Descri: 	Lê o nivel do pino (IDR)
+		static const uint32_t Clock
+				Descri: 	Mascara RCC_APB2Periph_GPIOx do porto
+
+
+	StpTim<Index>
+		static void Init(void)
+				Descri: 	Timer a STPDRV_TIMFREQ * 2, livre até 65535, com a IRQ ligada no NVIC (os
+							compares são ligados pelos eixos)
+		static const uint32_t Clock
+				Descri: 	Mascara RCC_APB1Periph_TIMx do timer
+
+
+	StepperAxis<Timer, Channel, Step, Dir>
+		static void Init(void)
+				Descri: 	Configura os pinos STEP e DIR como saídas, STEP a LOW
+		static StpAxisState State
+				Descri: 	Estado do eixo: CurDelay (meio periodo), Pos, Dir e DirPending
+
+		static void Start(uint16_t delay)
+				Descri: 	Primeiro compare daqui a "delay" ticks e liga a IRQ do canal, depois
+							State.CurDelay
+				 Parms: 	delay - ticks até ao primeiro flanco
+		static void Stop(void)
+				Descri: 	Desliga a IRQ do canal e põe o STEP a LOW
+		static void SetDir(mdir_t dir)
+				Descri: 	Muda o DIR de imediato, com o eixo parado. Com o eixo a andar usar
+							State.DirPending = 1, a IRQ inverte o DIR no flanco descendente
+		static bool Pending(void)
+				Descri: 	Para saber se o canal tem um compare por servir (SR & DIER)
+		static void OnCompare(void)
+				Descri: 	Corpo da IRQ do eixo, só chamar com Pending()
+
+
+	StpAxes<Axis...>
+		static void Init(void)
+				Descri: 	Liga os clocks de todos os portos e timers com uma chamada ao RCC por
+							barramento, inicializa os pinos e os timers
+		static void Isr(void)
+				Descri: 	Serve os canais pendentes, pela ordem dos eixos
+
+
+==============================================================================*/
+#ifndef  __stm32f_stpaxis_hpp    // DO NOT CHANGE
+#define  __stm32f_stpaxis_hpp    // DO NOT CHANGE
+
+#include "stm32f_stpdrv.h"
+
+// USER EDIT - Mapa dos portos e dos timers, indice -> registos (por defeito STM32F10x)
+#ifndef STPAXIS_GPIO
+#define STPAXIS_GPIO(n)			((GPIO_TypeDef *) (GPIOA_BASE + 0x400 * (n)))
+#endif
+#ifndef STPAXIS_TIM
+#define STPAXIS_TIM(n)			((TIM_TypeDef *) (TIM2_BASE + 0x400 * (n)))
+#endif
+
+
+/* ===========================================================================*/
+/* STOP ! - Private structs and vars - DO NOT CHANGE FROM THIS POINT ON 		*/
+/* ===========================================================================*/
+
+// o caminho da IRQ é sempre em linha, também com -Os
+#define STPAXIS_INLINE			inline __attribute__((always_inline))
+
+//---- Estado de um eixo, o mesmo que os campos do TMotor usados pela IRQ
+typedef struct {
+    __IO uint16_t	CurDelay;		// meio periodo em ticks do timer
+    __IO int32_t	Pos;
+    __IO mdir_t		Dir;
+    __IO uint8_t	DirPending;		// 1 = inverter o DIR no proximo flanco descendente
+} StpAxisState;
+
+//==============================================================================
+//	descri:  Um pino, Port = indice do porto (0 = GPIOA), Pin = GPIO_Pin_x
+//
+template <uint8_t Port, uint16_t Pin>
+struct StpPin {
+    static const uint32_t Clock = RCC_APB2Periph_GPIOA << Port;
+
+    static STPAXIS_INLINE GPIO_TypeDef *Regs(void)	{ return STPAXIS_GPIO(Port); }
+    static STPAXIS_INLINE void Set(void)			{ Regs()->BSRR = Pin; }
+    static STPAXIS_INLINE void Reset(void)			{ Regs()->BRR = Pin; }
+    static STPAXIS_INLINE bool IsSet(void)			{ return (Regs()->IDR & Pin) != 0; }
+
+    static void Init(void)
+    {
+        GPIO_InitTypeDef GPIO_InitStructure;
+
+        GPIO_InitStructure.GPIO_Pin = Pin;
+        GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP;
+        GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+        GPIO_Init(Regs(), &GPIO_InitStructure);
+    }
+};
+//==============================================================================
+
+//==============================================================================
+//	descri:  Um timer, Index = indice no APB1 (0 = TIM2, 1 = TIM3, 2 = TIM4)
+//
+template <uint8_t Index>
+struct StpTim {
+    static const uint32_t Clock = RCC_APB1Periph_TIM2 << Index;
+
+    static STPAXIS_INLINE TIM_TypeDef *Regs(void)	{ return STPAXIS_TIM(Index); }
+
+    static void Init(void)
+    {
+        TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+        NVIC_InitTypeDef NVIC_InitStructure;
+
+        // igual ao STPDRV_Init(), os compares ficam em TIM_OCMode_Timing (valor do reset)
+        TIM_TimeBaseStructure.TIM_Period = 65535;
+        TIM_TimeBaseStructure.TIM_Prescaler = (uint16_t) ((SystemCoreClock / 2) / (STPDRV_TIMFREQ * 2)) - 1;
+        TIM_TimeBaseStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+        TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+        TIM_TimeBaseStructure.TIM_RepetitionCounter = 0x0000;
+        TIM_TimeBaseInit(Regs(), &TIM_TimeBaseStructure);
+        TIM_UpdateDisableConfig(Regs(), ENABLE);
+
+        NVIC_InitStructure.NVIC_IRQChannel = (uint8_t) (TIM2_IRQn + Index);
+        NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = IRQ_STPDRV_PrePriority;
+        NVIC_InitStructure.NVIC_IRQChannelSubPriority = IRQ_STPDRV_Priority;
+        NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+        NVIC_Init(&NVIC_InitStructure);
+
+        TIM_Cmd(Regs(), ENABLE);
+    }
+};
+//==============================================================================
+
+//---- CCRx de um canal, resolvido por especialização (o layout dos registos muda com o alvo)
+template <uint8_t Channel> struct StpCcr;
+template <> struct StpCcr<1> { static STPAXIS_INLINE __IO uint16_t &Get(TIM_TypeDef *t) { return t->CCR1; } };
+template <> struct StpCcr<2> { static STPAXIS_INLINE __IO uint16_t &Get(TIM_TypeDef *t) { return t->CCR2; } };
+template <> struct StpCcr<3> { static STPAXIS_INLINE __IO uint16_t &Get(TIM_TypeDef *t) { return t->CCR3; } };
+template <> struct StpCcr<4> { static STPAXIS_INLINE __IO uint16_t &Get(TIM_TypeDef *t) { return t->CCR4; } };
+
+//==============================================================================
+//	descri:  Um eixo: canal Channel (1 a 4) do Timer, pinos Step e Dir (StpPin)
+//
+template <class Timer, uint8_t Channel, class Step, class Dir>
+struct StepperAxis {
+    typedef Timer	Tim;
+    static const uint16_t	ItMask = (uint16_t) (TIM_IT_CC1 << (Channel - 1));
+    static const uint32_t	GpioClock = Step::Clock | Dir::Clock;
+    static const uint32_t	TimClock = Timer::Clock;
+
+    static STPAXIS_INLINE __IO uint16_t &Ccr(void)	{ return StpCcr<Channel>::Get(Timer::Regs()); }
+
+    static void Init(void)
+    {
+        Step::Init();
+        Dir::Init();
+        Step::Reset();
+    }
+
+    static StpAxisState	State;
+
+    static STPAXIS_INLINE void Start(uint16_t delay)
+    {
+        Ccr() = (uint16_t) (Timer::Regs()->CNT + delay);
+        Timer::Regs()->SR = (uint16_t) ~ItMask;		// flag antiga daria um STEP já
+        Timer::Regs()->DIER |= ItMask;
+    }
+
+    static STPAXIS_INLINE void Stop(void)
+    {
+        Timer::Regs()->DIER &= (uint16_t) ~ItMask;
+        Step::Reset();
+    }
+
+    static STPAXIS_INLINE void SetDir(mdir_t dir)
+    {
+        if (dir == dir_CCW)
+            Dir::Reset();
+        else
+            Dir::Set();
+        State.Dir = dir;
+    }
+
+    static STPAXIS_INLINE bool Pending(void)
+    {
+        return (Timer::Regs()->SR & ItMask) && (Timer::Regs()->DIER & ItMask);
+    }
+
+    static STPAXIS_INLINE void OnCompare(void)
+    {
+        Ccr() += State.CurDelay;
+        if (Step::IsSet()) {
+            Step::Reset();
+            if (State.DirPending)
+                Flip();
+        } else {
+            Step::Set();
+            if (State.Dir == dir_CW)
+                State.Pos++;
+            else
+                State.Pos--;
+        }
+        Timer::Regs()->SR = (uint16_t) ~ItMask;
+    }
+
+private:
+    // caminho raro, fora do corpo da IRQ
+    static void __attribute__((noinline)) Flip(void)
+    {
+        SetDir(State.Dir == dir_CW ? dir_CCW : dir_CW);
+        if (State.CurDelay < STPDRV_DIRSETUP)
+            Ccr() += (uint16_t) (STPDRV_DIRSETUP - State.CurDelay);
+        State.DirPending = 0;
+    }
+};
+
+template <class Timer, uint8_t Channel, class Step, class Dir>
+StpAxisState StepperAxis<Timer, Channel, Step, Dir>::State;
+//==============================================================================
+
+//==============================================================================
+//	descri:  Conjunto de eixos servidos pela mesma IRQ, as mascaras do RCC são juntas em
+//				tempo de compilação
+//
+template <class... Axis> struct StpAxes;
+
+template <>
+struct StpAxes<> {
+    static const uint32_t	GpioClock = 0;
+    static const uint32_t	TimClock = 0;
+
+    static STPAXIS_INLINE void InitAxes(void) {}
+    static STPAXIS_INLINE void InitTims(uint32_t done) { (void) done; }
+    static STPAXIS_INLINE void Isr(void) {}
+};
+
+template <class First, class... Rest>
+struct StpAxes<First, Rest...> {
+    static const uint32_t	GpioClock = First::GpioClock | StpAxes<Rest...>::GpioClock;
+    static const uint32_t	TimClock = First::TimClock | StpAxes<Rest...>::TimClock;
+
+    static void Init(void)
+    {
+        RCC_APB2PeriphClockCmd(GpioClock, ENABLE);
+        RCC_APB1PeriphClockCmd(TimClock, ENABLE);
+        InitAxes();
+        InitTims(0);
+    }
+
+    static STPAXIS_INLINE void InitAxes(void)
+    {
+        First::Init();
+        StpAxes<Rest...>::InitAxes();
+    }
+
+    // cada timer só uma vez, mesmo com vários eixos
+    static STPAXIS_INLINE void InitTims(uint32_t done)
+    {
+        if (!(done & First::TimClock))
+            First::Tim::Init();
+        StpAxes<Rest...>::InitTims(done | First::TimClock);
+    }
+
+    static STPAXIS_INLINE void Isr(void)
+    {
+        if (First::Pending())
+            First::OnCompare();
+        StpAxes<Rest...>::Isr();
+    }
+};
+//==============================================================================
+
+#endif  // __stm32f_stpaxis_hpp
+
+//=============================================================================
+// EOF stm32f_stpaxis.hpp
@@ -0,0 +1,480 @@
+/*=============================================================================
+
+    @file    stm32f_stpcom.c
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   Binary command protocol over USART for the STM32F Stepper Driver
+
+   This Software is released under no garanty.
+    You may use this software for personal use.
+    Use for commercial and/or profit applications is strictly prohibited.
+
+    COPYRIGHT (C) 2026 STM32StepperDriver contributors
+
+   Compiled under C99 (ISO/IEC 9899:1999) version
+   please use the "--c99" compiler directive
+
+   Description and Usage: See stm32f_stpcom.h
+
+==============================================================================*/
+#include "stm32f_stpcom.h"
+
+/* ===========================================================================*/
+/* Private structs and vars - DO NOT CHANGE !											*/
+/* ===========================================================================*/
+
+//---- Acesso ao buffer circular de recepção (índices livres, a máscara é aplicada aqui)
+#define RXB(i)		RxBuf[(uint16_t) (i) & (STPCOM_RXSIZE - 1)]
+
+//---- Buffers
+static uint8_t 			RxBuf[STPCOM_RXSIZE];	// escrito pelo DMA em modo circular
+static uint16_t 			RxRd;							// proximo byte a interpretar
+static __IO uint32_t 	RxLaps;						// voltas do DMA RX ao buffer (IRQ de transfer complete)
+static uint32_t 			RxUsed;						// bytes interpretados desde o STPCOM_Init()
+static uint8_t 			TxBuf[STPCOM_TXSIZE];
+static __IO uint16_t 	TxHead;						// proximo byte livre (escrito no ciclo principal)
+static __IO uint16_t 	TxTail;						// inicio da transferência DMA em curso
+static __IO uint16_t 	TxLen;						// bytes da transferência DMA em curso, ZERO se parado
+
+static stpcom_stats_t 	Stats;
+
+//---- CRC16 CCITT (poly 0x1021), tabela em flash
+static const uint16_t CrcTable[256] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7, 0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6, 0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485, 0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4, 0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823, 0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12, 0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41, 0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70, 0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F, 0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E, 0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D, 0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C, 0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB, 0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A, 0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9, 0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8, 0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+//----- Private Function Prototypes - DO NOT USE
+static void 		__Exec(uint16_t i, uint8_t len);
+static void 		__Reply(uint8_t cmd, uint8_t status, const uint8_t *data, uint8_t len);
+static void 		__TxKick(void);
+static uint16_t 	__RxU16(uint16_t i);
+#ifdef STPDRV_USE_TRACE
+static void 		__TraceReply(uint16_t first);
+#endif
+
+//==============================================================================
+//
+void STPCOM_Init(void)
+{
+    GPIO_InitTypeDef 	GPIO_InitStructure;
+    USART_InitTypeDef 	USART_InitStructure;
+    DMA_InitTypeDef 		DMA_InitStructure;
+    NVIC_InitTypeDef 	NVIC_InitStructure;
+
+    RxRd = 0;
+    RxLaps = RxUsed = 0;
+    TxHead = TxTail = TxLen = 0;
+
+    //----- Clocks
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOA | RCC_APB2Periph_AFIO, ENABLE);	// USER EDIT - se STPCOM_PORT não for GPIOA
+    RCC_APB2PeriphClockCmd(STPCOM_USART_APB, ENABLE);		// USER EDIT - RCC_APB1PeriphClockCmd para USART2/3
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    //----- GPIO - TX em alternate function, RX em input
+    GPIO_InitStructure.GPIO_Pin = STPCOM_TX_PIN;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_Init(STPCOM_PORT, &GPIO_InitStructure);
+    GPIO_InitStructure.GPIO_Pin = STPCOM_RX_PIN;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_FLOATING;
+    GPIO_Init(STPCOM_PORT, &GPIO_InitStructure);
+
+    //----- DMA RX - circular, o ciclo principal lê atrás do DMA
+    DMA_DeInit(STPCOM_DMA_RX);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t) &STPCOM_USART->DR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t) RxBuf;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = STPCOM_RXSIZE;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(STPCOM_DMA_RX, &DMA_InitStructure);
+    DMA_ITConfig(STPCOM_DMA_RX, DMA_IT_TC, ENABLE);		// conta as voltas, para detectar overruns
+    DMA_Cmd(STPCOM_DMA_RX, ENABLE);
+
+    //----- DMA TX - normal, endereço e tamanho carregados em __TxKick()
+    DMA_DeInit(STPCOM_DMA_TX);
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t) TxBuf;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_InitStructure.DMA_BufferSize = 1;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+    DMA_Init(STPCOM_DMA_TX, &DMA_InitStructure);
+    DMA_ITConfig(STPCOM_DMA_TX, DMA_IT_TC, ENABLE);
+
+    NVIC_InitStructure.NVIC_IRQChannel = STPCOM_DMA_TX_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = IRQ_STPCOM_PrePriority;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = IRQ_STPCOM_Priority;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+    NVIC_InitStructure.NVIC_IRQChannel = STPCOM_DMA_RX_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+
+    //----- USART
+    USART_InitStructure.USART_BaudRate = STPCOM_BAUD;
+    USART_InitStructure.USART_WordLength = USART_WordLength_8b;
+    USART_InitStructure.USART_StopBits = USART_StopBits_1;
+    USART_InitStructure.USART_Parity = USART_Parity_No;
+    USART_InitStructure.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
+    USART_InitStructure.USART_Mode = USART_Mode_Rx | USART_Mode_Tx;
+    USART_Init(STPCOM_USART, &USART_InitStructure);
+    USART_DMACmd(STPCOM_USART, USART_DMAReq_Rx | USART_DMAReq_Tx, ENABLE);
+    USART_Cmd(STPCOM_USART, ENABLE);
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   IRQ de fim de transferência do DMA TX, começa a proxima se houver dados
+// USER EDIT - Mudar o nome do IRQ se o canal do DMA for alterado
+void DMA1_Channel4_IRQHandler(void)
+{
+    if (DMA1->ISR & STPCOM_DMA_TX_TC) {
+        DMA1->IFCR = STPCOM_DMA_TX_CLR;
+        TxTail = (TxTail + TxLen) & (STPCOM_TXSIZE - 1);
+        TxLen = 0;
+        __TxKick();
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   IRQ de fim de volta do DMA RX, conta as voltas ao buffer circular
+// USER EDIT - Mudar o nome do IRQ se o canal do DMA for alterado
+void DMA1_Channel5_IRQHandler(void)
+{
+    if (DMA1->ISR & STPCOM_DMA_RX_TC) {
+        DMA1->IFCR = STPCOM_DMA_RX_CLR;
+        RxLaps++;
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//
+void STPCOM_Poll(void)
+{
+    uint16_t wr, avail, crc, k, rd;
+    uint32_t laps, tc;
+    uint8_t len;
+
+    // posição de escrita do DMA, CNDTR conta para baixo a partir de STPCOM_RXSIZE. O CNDTR
+    // volta a STPCOM_RXSIZE no fim da volta, lido entre duas leituras iguais das voltas e da
+    // flag de transfer complete. Com a flag posta o CNDTR já foi recarregado mas a IRQ ainda
+    // não contou a volta, sem a somar aqui o wr andava para trás e dava um falso overrun
+    do {
+        laps = RxLaps;
+        tc = DMA1->ISR & STPCOM_DMA_RX_TC;
+        wr = (uint16_t) ((STPCOM_RXSIZE - STPCOM_DMA_RX->CNDTR) & (STPCOM_RXSIZE - 1));
+    } while ((laps != RxLaps) || (tc != (DMA1->ISR & STPCOM_DMA_RX_TC)));
+    if (tc)
+        laps++;
+
+    // o DMA passou o ultimo byte por interpretar: o buffer tem bytes de voltas diferentes,
+    // descarta tudo e volta a procurar o sync nos bytes seguintes
+    if ((uint32_t) (laps * STPCOM_RXSIZE + wr - RxUsed) >= STPCOM_RXSIZE) {
+        Stats.RxOverruns++;
+        RxUsed = laps * STPCOM_RXSIZE + wr;
+        RxRd = wr;
+        return;
+    }
+    rd = RxRd;
+
+    for (;;) {
+        avail = (wr - RxRd) & (STPCOM_RXSIZE - 1);
+        if (avail < 5)		// frame minimo: sync, len, cmd e crc
+            break;
+        if (RXB(RxRd) != STPCOM_SYNC) {
+            RxRd++;
+            Stats.SyncErrors++;
+            continue;
+        }
+        len = RXB(RxRd + 1);
+        if (len > STPCOM_MAXPAYLOAD) {
+            RxRd++;
+            Stats.SyncErrors++;
+            continue;
+        }
+        if (avail < (uint16_t) (len + 5))
+            break;			// frame ainda incompleto
+
+        crc = 0xFFFF;
+        for (k = 1; k < (uint16_t) (len + 3); k++)
+            crc = (uint16_t) ((crc << 8) ^ CrcTable[((crc >> 8) ^ RXB(RxRd + k)) & 0xFF]);
+        if (crc != __RxU16(RxRd + len + 3)) {
+            RxRd++;			// volta a procurar o sync a seguir a este
+            Stats.CrcErrors++;
+            continue;
+        }
+
+        __Exec(RxRd + 2, len);
+        Stats.Frames++;
+        RxRd = (RxRd + len + 5) & (STPCOM_RXSIZE - 1);
+    }
+    RxRd &= (STPCOM_RXSIZE - 1);
+    RxUsed += (uint16_t) (RxRd - rd) & (STPCOM_RXSIZE - 1);
+}
+//==============================================================================
+
+//==============================================================================
+//
+int16_t STPCOM_Send(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    uint16_t head, crc, k;
+    uint32_t primask;
+    uint8_t b;
+
+    if ((len > STPCOM_MAXPAYLOAD) ||
+        (((TxTail - TxHead - 1) & (STPCOM_TXSIZE - 1)) < (uint16_t) (len + 5))) {
+        Stats.TxDrops++;
+        return 0;
+    }
+
+    head = TxHead;
+    TxBuf[head] = STPCOM_SYNC;
+    head = (head + 1) & (STPCOM_TXSIZE - 1);
+    crc = 0xFFFF;
+    for (k = 0; k < (uint16_t) (len + 2); k++) {
+        b = (k == 0) ? len : ((k == 1) ? cmd : payload[k - 2]);
+        crc = (uint16_t) ((crc << 8) ^ CrcTable[((crc >> 8) ^ b) & 0xFF]);
+        TxBuf[head] = b;
+        head = (head + 1) & (STPCOM_TXSIZE - 1);
+    }
+    TxBuf[head] = (uint8_t) crc;
+    head = (head + 1) & (STPCOM_TXSIZE - 1);
+    TxBuf[head] = (uint8_t) (crc >> 8);
+    head = (head + 1) & (STPCOM_TXSIZE - 1);
+
+    // __TxKick também corre na IRQ do DMA
+    primask = __get_PRIMASK();
+    __disable_irq();
+    TxHead = head;
+    if (TxLen == 0)
+        __TxKick();
+    __set_PRIMASK(primask);
+    return 1;
+}
+//==============================================================================
+
+//==============================================================================
+//
+uint16_t STPCOM_TxFree(void)
+{
+    uint16_t f = (TxTail - TxHead - 1) & (STPCOM_TXSIZE - 1);
+
+    return (f > 5) ? f - 5 : 0;
+}
+//==============================================================================
+
+//==============================================================================
+//
+const stpcom_stats_t *STPCOM_GetStats(void)
+{
+    return &Stats;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Executa um comando directamente a partir do buffer circular
+//	params:	i - índice (sem máscara) do byte CMD no buffer de recepção
+//          len - numero de bytes do payload
+//	return:	nada
+//
+static void __Exec(uint16_t i, uint8_t len)
+{
+    uint8_t cmd = RXB(i), motor = RXB(i + 1), dir = RXB(i + 2), q[8];
+    uint16_t speed;
+    int32_t pos;
+
+    switch (cmd) {
+    case STPCOM_CMD_MOVE:
+        if (len != 4)
+            break;
+        speed = __RxU16(i + 3);
+        if ((motor > MOTOR2) || (dir > dir_CCW) ||
+            (speed < STPDRV_MINSETPSEC) || (speed > STPDRV_GetMaxSpeed(motor))) {
+            __Reply(cmd, STPCOM_NAK_PARM, 0, 0);
+            return;
+        }
+        STPDRV_Move(motor, (mdir_t) dir, (int16_t) speed);
+        __Reply(cmd, STPCOM_ACK, 0, 0);
+        return;
+
+    case STPCOM_CMD_GOTO:
+        if (len != 8)
+            break;
+        // o STPDRV_Goto ainda não está implementado no driver
+        __Reply(cmd, STPCOM_NAK_UNSUP, 0, 0);
+        return;
+
+    case STPCOM_CMD_STOP:
+        if (len != 2)
+            break;
+        if (motor > MOTOR2) {
+            __Reply(cmd, STPCOM_NAK_PARM, 0, 0);
+            return;
+        }
+        STPDRV_Stop(motor, RXB(i + 2));
+        __Reply(cmd, STPCOM_ACK, 0, 0);
+        return;
+
+    case STPCOM_CMD_SETRAMP:
+        if (len != 3)
+            break;
+        speed = __RxU16(i + 2);
+        if ((motor > MOTOR2) || (speed < STPCOM_MINRAMP) || (speed > 32767)) {
+            __Reply(cmd, STPCOM_NAK_PARM, 0, 0);
+            return;
+        }
+        STPDRV_SetRamp(motor, (int16_t) speed);
+        __Reply(cmd, STPCOM_ACK, 0, 0);
+        return;
+
+    case STPCOM_CMD_QUERY:
+        if (len != 1)
+            break;
+        if (motor > MOTOR2) {
+            __Reply(cmd, STPCOM_NAK_PARM, 0, 0);
+            return;
+        }
+        pos = STPDRV_GetPos(motor);
+        speed = STPDRV_GetSpeed(motor);
+        q[0] = (uint8_t) pos;
+        q[1] = (uint8_t) (pos >> 8);
+        q[2] = (uint8_t) (pos >> 16);
+        q[3] = (uint8_t) (pos >> 24);
+        q[4] = (uint8_t) STPDRV_GetDir(motor);
+        q[5] = (uint8_t) STPDRV_GetState(motor);
+        q[6] = (uint8_t) speed;
+        q[7] = (uint8_t) (speed >> 8);
+        __Reply(cmd, STPCOM_ACK, q, sizeof(q));
+        return;
+
+#ifdef STPDRV_USE_TRACE
+    case STPCOM_CMD_TRACE:
+        if (len != 2)
+            break;
+        __TraceReply(__RxU16(i + 1));
+        return;
+#endif
+
+    default:
+        __Reply(cmd, STPCOM_NAK_CMD, 0, 0);
+        return;
+    }
+    __Reply(cmd, STPCOM_NAK_LEN, 0, 0);
+}
+//==============================================================================
+
+#ifdef STPDRV_USE_TRACE
+//==============================================================================
+//	descri:  Resposta ao STPCOM_CMD_TRACE. O trace fica suspenso desde o pedido do indice 0 até ser
+//				enviado o ultimo evento, para a cópia ser coerente entre frames
+//	params:	first - indice do primeiro evento a enviar
+//	return:	nada
+//
+static void __TraceReply(uint16_t first)
+{
+    mtrace_rec_t rec[STPCOM_TRACE_PERFRAME];
+    uint8_t q[4 + STPCOM_TRACE_PERFRAME * 8], *p = &q[4];
+    uint16_t count, n, k;
+
+    if (first == 0)
+        STPDRV_TraceEnable(0);
+    count = STPDRV_TraceCount();
+    n = STPDRV_TraceDump(rec, first, STPCOM_TRACE_PERFRAME);
+    if (first + n >= count)
+        STPDRV_TraceEnable(1);
+
+    q[0] = (uint8_t) first;
+    q[1] = (uint8_t) (first >> 8);
+    q[2] = (uint8_t) count;
+    q[3] = (uint8_t) (count >> 8);
+    for (k = 0; k < n; k++) {
+        *p++ = (uint8_t) rec[k].Time;
+        *p++ = (uint8_t) (rec[k].Time >> 8);
+        *p++ = (uint8_t) (rec[k].Time >> 16);
+        *p++ = (uint8_t) (rec[k].Time >> 24);
+        *p++ = rec[k].Event;
+        *p++ = rec[k].Motor;
+        *p++ = (uint8_t) rec[k].Data;
+        *p++ = (uint8_t) (rec[k].Data >> 8);
+    }
+    __Reply(STPCOM_CMD_TRACE, STPCOM_ACK, q, (uint8_t) (p - q));
+}
+//==============================================================================
+#endif
+
+//==============================================================================
+//	descri:  Envia a resposta a um comando
+//	params:	cmd - comando recebido
+//          status - STPCOM_ACK ou STPCOM_NAK_xxx
+//          data - dados a seguir ao estado (pode ser ZERO)
+//          len - numero de bytes de data
+//	return:	nada
+//
+static void __Reply(uint8_t cmd, uint8_t status, const uint8_t *data, uint8_t len)
+{
+    uint8_t p[STPCOM_MAXPAYLOAD];
+    uint8_t k;
+
+    p[0] = status;
+    for (k = 0; k < len; k++)
+        p[k + 1] = data[k];
+    STPCOM_Send(cmd | STPCOM_REPLY, p, len + 1);
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Começa a transferência DMA do bloco contiguo seguinte do buffer de transmissão.
+//				Chamada com as IRQs desligadas ou na IRQ do DMA
+//	params:	nada
+//	return:	nada
+//
+static void __TxKick(void)
+{
+    uint16_t head = TxHead, len;
+
+    if (head == TxTail)
+        return;
+    len = (head > TxTail) ? (head - TxTail) : (STPCOM_TXSIZE - TxTail);
+    TxLen = len;
+    STPCOM_DMA_TX->CCR &= ~DMA_CCR1_EN;
+    STPCOM_DMA_TX->CMAR  = (uint32_t) &TxBuf[TxTail];
+    STPCOM_DMA_TX->CNDTR = len;
+    STPCOM_DMA_TX->CCR |= DMA_CCR1_EN;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Lê valores little endian do buffer circular de recepção
+//	params:	i - índice (sem máscara) do primeiro byte
+//	return:	valor
+//
+static uint16_t __RxU16(uint16_t i)
+{
+    return (uint16_t) (RXB(i) | (RXB(i + 1) << 8));
+}
+//==============================================================================
+
+//=============================================================================
+// EOF stm32f_stpcom.c
@@ -0,0 +1,190 @@
+/*=============================================================================
+
+	@file    stm32f_stpcom.h
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   Binary command protocol over USART for the STM32F Stepper Driver
+
+   This Software is released under no garanty.
+	You may use this software for personal use.
+	Use for commercial and/or profit applications is strictly prohibited.
+
+  	COPYRIGHT (C) 2026 STM32StepperDriver contributors
+
+   Compiled under C99 (ISO/IEC 9899:1999) version
+   please use the "--c99" compiler directive
+
+   ===================================================================
+	                    Description (in portuguese)
+   ===================================================================
+	- 	Protocolo binário com frames para controlar o driver a partir de um PC
+	- 	Recepção por DMA num buffer circular, sem interrupts por byte (só uma por volta do buffer,
+		para contar os overruns)
+	- 	Os frames são interpretados directamente no buffer circular (sem cópias)
+	- 	Transmissão por DMA a partir de um buffer circular, nunca bloqueia
+	- 	CRC16 CCITT em todos os frames
+
+
+   ===================================================================
+                       Frame format
+   ===================================================================
+	[0xA5] [LEN] [CMD] [PAYLOAD: LEN bytes] [CRC16 low] [CRC16 high]
+
+	- 	CRC16 CCITT (poly 0x1021, init 0xFFFF) calculado sobre LEN, CMD e PAYLOAD
+	- 	Valores com mais de um byte em little endian
+	- 	Cada comando recebe uma resposta com CMD | 0x80 e o primeiro byte do payload com o
+		estado (STPCOM_ACK, STPCOM_NAK_LEN, STPCOM_NAK_PARM, STPCOM_NAK_CMD ou STPCOM_NAK_UNSUP)
+
+	CMD						PAYLOAD										RESPOSTA (após o estado)
+	STPCOM_CMD_MOVE		motor u8, dir u8, speed u16				-
+	STPCOM_CMD_GOTO		motor u8, dir u8, pos i32, speed u16	-
+	STPCOM_CMD_STOP		motor u8, hardstop u8						-
+	STPCOM_CMD_SETRAMP	motor u8, rampspeed u16						-
+	STPCOM_CMD_QUERY		motor u8										pos i32, dir u8, state u8, speed u16
+	STPCOM_CMD_TRACE		first u16									first u16, count u16, até 3 eventos de 8 bytes:
+																				time u32, event u8, motor u8, data u16
+
+	O speed do STPCOM_CMD_MOVE tem de estar entre STPDRV_MINSETPSEC e STPDRV_GetMaxSpeed(motor) e o
+	rampspeed do STPCOM_CMD_SETRAMP entre STPCOM_MINRAMP e 32767, senão a resposta é STPCOM_NAK_PARM.
+	O STPCOM_CMD_GOTO responde sempre STPCOM_NAK_UNSUP enquanto o STPDRV_Goto não estiver implementado.
+
+	STPCOM_CMD_TRACE só existe com STPDRV_USE_TRACE. O pedido com first = 0 suspende o trace, que volta
+	a ser ligado depois de enviado o ultimo evento. O host pede first = 0, 3, 6 ... até count e
+	passa os eventos ao Tools/stptrace.c
+
+
+   ===================================================================
+                       How to use
+   ===================================================================
+	1 - Editar este ficheiro e definir a USART, pinos e canais de DMA
+	2 - Chamar STPDRV_Init() e depois STPCOM_Init()
+	3 - Chamar STPCOM_Poll() com frequência no ciclo principal
+
+
+   ===================================================================
+                               API
+   ===================================================================
+	void STPCOM_Init(void)
+			Descri: Inicializa a USART, os DMA e os buffers
+			 Parms: 	none
+			Return: 	none
+
+
+	void STPCOM_Poll(void)
+			Descri: 	Interpreta e executa todos os frames completos recebidos
+			 Parms: 	none
+			Return:  none
+
+
+	int16_t STPCOM_Send(uint8_t cmd, const uint8_t *payload, uint8_t len)
+			Descri: 	Envia um frame (é copiado para o buffer de transmissão, não bloqueia)
+			 Parms: 	cmd - comando
+						payload - dados do frame
+						len - numero de bytes do payload, maximo STPCOM_MAXPAYLOAD
+			Return:  1 se OK, 0 se não houver espaço no buffer (o frame é descartado e contado)
+
+
+	uint16_t STPCOM_TxFree(void)
+			Descri: 	Para saber quantos bytes de payload cabem agora no buffer de transmissão
+			 Parms: 	none
+			Return:  numero de bytes (já descontado o cabeçalho e o CRC de um frame)
+
+
+	const stpcom_stats_t *STPCOM_GetStats(void)
+			Descri: 	Para obter os contadores do protocolo
+			 Parms: 	none
+			Return:  ponteiro para os contadores
+
+
+==============================================================================*/
+#ifndef  __stm32f_stpcom_h    // DO NOT CHANGE
+#define  __stm32f_stpcom_h    // DO NOT CHANGE
+
+#include "stm32f_stpdrv.h"
+#include "stm32f_stphal.h"
+
+#ifdef STPHAL_F4
+#error "stm32f_stpcom: só STM32F10x (USART e canais de DMA do StdPeriph do F1), ver stm32f_stphal.h"
+#endif
+
+#include <stm32f10x_usart.h>
+#include <stm32f10x_dma.h>
+
+
+// USER EDIT - Edit the lines below to reflect your hardware
+#define STPCOM_USART				USART1
+#define STPCOM_USART_APB			RCC_APB2Periph_USART1	// APB2 clock da USART (USART1), ver STPCOM_Init() se for APB1
+#define STPCOM_BAUD				115200
+
+#define STPCOM_PORT				GPIOA						// IO port dos pinos TX e RX
+#define STPCOM_TX_PIN			GPIO_Pin_9
+#define STPCOM_RX_PIN			GPIO_Pin_10
+
+#define STPCOM_DMA_RX			DMA1_Channel5			// canal DMA do RX da USART (ver reference manual)
+#define STPCOM_DMA_RX_IRQn		DMA1_Channel5_IRQn
+#define STPCOM_DMA_RX_TC		DMA_ISR_TCIF5			// flag de transfer complete do canal RX
+#define STPCOM_DMA_RX_CLR		DMA_IFCR_CGIF5			// clear das flags do canal RX
+#define STPCOM_DMA_TX			DMA1_Channel4			// canal DMA do TX da USART
+#define STPCOM_DMA_TX_IRQn		DMA1_Channel4_IRQn
+#define STPCOM_DMA_TX_TC		DMA_ISR_TCIF4			// flag de transfer complete do canal TX
+#define STPCOM_DMA_TX_CLR		DMA_IFCR_CGIF4			// clear das flags do canal TX
+
+
+// USER EDIT - If you use NVIC Preemption Priority Bits edit de 2 lines below, must be lower
+//					priority than the stepper driver IRQ
+#define IRQ_STPCOM_PrePriority	0x01
+#define IRQ_STPCOM_Priority      0x00
+
+
+
+/* ===========================================================================*/
+/* STOP ! - Private structs and vars - DO NOT CHANGE FROM THIS POINT ON 		*/
+/* ===========================================================================*/
+
+#define STPCOM_RXSIZE			256		// buffer circular do DMA RX, potência de 2
+#define STPCOM_TXSIZE			256		// buffer circular do TX, potência de 2
+#define STPCOM_MAXPAYLOAD		32
+#define STPCOM_REPLY_ROOM		(STPCOM_MAXPAYLOAD + 5)	// frame da resposta mais longa, reservado pela telemetria
+#define STPCOM_TRACE_PERFRAME	3			// eventos do trace por resposta (1 + 4 + 3 * 8 bytes)
+#define STPCOM_SYNC				0xA5
+#define STPCOM_MINRAMP			4			// rampspeed minimo, 2 x o RampSlop do driver
+
+//---- Comandos
+#define STPCOM_CMD_MOVE			0x01
+#define STPCOM_CMD_GOTO			0x02
+#define STPCOM_CMD_STOP			0x03
+#define STPCOM_CMD_SETRAMP		0x04
+#define STPCOM_CMD_QUERY		0x05
+#define STPCOM_CMD_TRACE		0x06
+#define STPCOM_REPLY				0x80		// bit das respostas
+#define STPCOM_TLM_SAMPLES		0x40		// frame de telemetria enviado pelo driver (ver stm32f_stptlm.h)
+
+//---- Estado das respostas
+#define STPCOM_ACK				0x00
+#define STPCOM_NAK_LEN			0x01		// tamanho do payload errado
+#define STPCOM_NAK_PARM			0x02		// parâmetro inválido
+#define STPCOM_NAK_CMD			0x03		// comando desconhecido
+#define STPCOM_NAK_UNSUP		0x04		// comando conhecido mas não suportado pelo driver
+
+typedef struct {
+    uint32_t	Frames;			// frames válidos executados
+    uint32_t	CrcErrors;		// frames com CRC errado
+    uint32_t	SyncErrors;		// bytes descartados à procura do inicio de um frame
+    uint32_t	TxDrops;			// frames de transmissão descartados por falta de espaço
+    uint32_t	RxOverruns;		// vezes que o DMA RX passou o ultimo byte por interpretar (bytes descartados)
+} stpcom_stats_t;
+
+
+//-----------------------------------------------------------------------------
+// Exported API Funcs
+void 		STPCOM_Init(void);
+void 		STPCOM_Poll(void);
+int16_t 	STPCOM_Send(uint8_t cmd, const uint8_t *payload, uint8_t len);
+uint16_t 	STPCOM_TxFree(void);
+const stpcom_stats_t *STPCOM_GetStats(void);
+
+#endif  // __stm32f_stpcom_h
+
+//=============================================================================
+// EOF stm32f_stpcom.h
@@ -24,11 +24,24 @@
 
 ==============================================================================*/
 #include "stm32f_stpdrv.h"
+#include "stm32f_stphal.h"
 
 /* ===========================================================================*/
 /* Private structs and vars - DO NOT CHANGE !											*/
 /* ===========================================================================*/
 
+//---- Ramp plan, segmentos da rampa calculados em __SetTargetSpeed
+#ifdef STPDRV_USE_BANDS
+#define STPDRV_PLANLEN		(4 * STPDRV_MAXBANDS + 3)	// 2 pernas (inversão) com 2 segmentos por banda + 1 segmento final cada, + a inversão
+#else
+#define STPDRV_PLANLEN		3								// desacelerar, inverter, acelerar
+#endif
+
+typedef struct {
+    uint16_t			Speed;			// Velocidade a atingir em STEPS/SEC, ZERO indica inversão do DIR
+    uint16_t			Slop;				// Incremento/decremento por RampDelay a usar neste segmento
+} TRampSeg;
+
 //---- Motor struct
 typedef struct {
     int32_t		Pos;				// Actual position, in steps count
@@ -36,24 +49,186 @@ typedef struct {
     mstate_t		State;			// Actual motor state (see mstate_t)
 
     // control fields - IGNORE THIS FIELDS
-    uint16_t			CurDelay;         // Delay actual a ser carregado para o CCR
+    stphal_tick_t	CurDelay;         // Delay actual a ser carregado para o CCR
     uint16_t 		RampDelay;      	// Acel/Deacel rate (calculado a partir dos steps/sec/sec passados na função "STPDRV_SetRamp"
     uint16_t 		RampSlop;    		// Slope increment/decrement for each RampDelay
+    uint16_t 		CurSlop;    		// Slope do segmento actual (RampSlop ou maior ao atravessar uma banda de ressonância)
     __IO uint16_t	TargetSpeed;		// Velocidade a atingir em STEPS/SEC, se ZERO indica que não existe nada para atingir.
     // Se for maior que ZERO indica o valor para o qual o sistema deve progredir, o incremento
     // ou decremento de CurDelay é efectuado na rotina IRQ do timer que controla  as acelerações
     // e desacelerações
-    uint16_t			TargetSpeed2;		// Executado depois de TargetSpeed quando a Dir pretendida é diferente e é necessário parar
-    // motor primeiro. Se maior que ZERO inverter a direcção após terminar TargetSpeed e executar
-    // novamente com este valor
     __IO uint16_t	TargetCurSpeed; 	// Velocidade em STEPS/SEC actual da aceleração/desaceleração
     mstate_t			TargetState;		// Estado a estabelecer DEPOIS de CurDelay ter alcançado TargetDelay
+    __IO uint8_t		DirPending;			// Se 1 a direcção deve ser invertida no proximo flanco descendente do STEP
+    // (ver __DirPendingFlip), depois disso passa ao segmento seguinte
+    TRampSeg			Plan[STPDRV_PLANLEN];	// Segmentos da rampa, TargetSpeed é o Speed do segmento actual
+    uint8_t			PlanIdx;			// Proximo segmento a carregar
+    uint8_t			PlanLen;			// Numero de segmentos do plano
+    uint16_t			PlanSpeed;		// Velocidade final do plano (ZERO se não houver plano)
+#ifdef STPDRV_USE_ENCODER
+    __IO uint16_t	Inject;			// STEPs de correcção pendentes, STEPs extra que não contam em Pos (ver STPDRV_Inject)
+    __IO uint8_t		InjHalf;			// Meios periodos curtos que faltam na janela do STEP extra (ver __InjectStart)
+#endif
+#ifdef STPDRV_USE_MICROSTEP
+    uint8_t			MsLevel;			// Resolução actual (indice em Micros)
+    __IO uint8_t		MsNext;			// Resolução pedida pela rampa, a mudança é feita no proximo full step (ver __MsSwitch)
+    __IO uint16_t	MsMul;			// Microsteps do nivel 0 por STEP na resolução actual
+    int32_t			MsOrg;			// Pos - MsOrg é a posição do indexador do IC, full step nos multiplos de STPDRV_MS_FULL
+    uint16_t			MsMax;			// Velocidade maxima em steps/sec com o ultimo nivel configurado
+#endif
 } TMotor;
 
 
 //---- Motor control vars
-TMotor Motors[2] = {{(int32_t)0x0, (mdir_t)0, (mstate_t)0, (uint16_t) 0xffff },
-                    {(int32_t)0x0, (mdir_t)0, (mstate_t)0, (uint16_t) 0xffff }};
+TMotor Motors[2] = {{(int32_t)0x0, (mdir_t)0, (mstate_t)0, (stphal_tick_t) STPHAL_TICK_MAX },
+                    {(int32_t)0x0, (mdir_t)0, (mstate_t)0, (stphal_tick_t) STPHAL_TICK_MAX }};
+
+#ifdef STPDRV_USE_BANDS
+//---- Resonance bands, por ordem crescente e sem sobreposição. High == 0 indica banda não usada
+typedef struct {
+    uint16_t			Low;				// Limite inferior em STEPS/SEC
+    uint16_t			High;				// Limite superior em STEPS/SEC
+    uint16_t			SlopMul;			// Multiplicador do RampSlop para atravessar a banda
+} TBand;
+
+TBand Bands[2][STPDRV_MAXBANDS];
+#endif
+
+#ifdef STPDRV_USE_MICROSTEP
+//---- Resoluções do microstepping, por ordem crescente de Mul. Mul == 0 indica nivel não usado
+typedef struct {
+    uint16_t			Mul;				// Microsteps do nivel 0 por STEP
+    uint16_t			Pins;				// Pinos MSx a HIGH
+    uint16_t			Up;				// Velocidade em STEPS/SEC a partir da qual se passa a este nivel
+    uint16_t			Down;				// Velocidade abaixo da qual se volta ao nivel anterior
+} TMicro;
+
+TMicro Micros[2][STPDRV_MS_LEVELS];
+
+#define MS_MUL(mt)				Motors[mt].MsMul
+#define MS_INJECTED(mt)		Motors[mt].MsOrg -= (Motors[mt].Dir == dir_CW) ? Motors[mt].MsMul : -Motors[mt].MsMul
+#define MAX_SPEED(mt)			Motors[mt].MsMax
+#define CUR_SPEED(mt)			__MsSpeed(mt)
+#define SPEED2DELAY(mt, sp)	__MsDelay(mt, sp)
+#else
+#define MS_MUL(mt)				1
+#define MS_INJECTED(mt)
+#define MAX_SPEED(mt)			STPDRV_MAXSETPSEC
+#define CUR_SPEED(mt)			(STPDRV_TIMFREQ / Motors[mt].CurDelay)
+#define SPEED2DELAY(mt, sp)	(STPDRV_TIMFREQ / (sp))
+#endif
+
+#ifdef STPDRV_USE_ARC
+//---- Arc struct, interpolação circular MOTOR1 (X) / MOTOR2 (Y). Coordenadas relativas ao centro
+typedef struct {
+    __IO uint8_t		Active;			// Se 1 o canal 1 do timer executa __OnArcTimer em vez do STEP do MOTOR1
+    uint8_t			Phase;			// 1 = proximo evento é o flanco ascendente dos STEP
+    uint8_t			Oct;				// Octante actual (ver __ArcOctant)
+    uint8_t			Cross;			// Fronteiras de octante que faltam atravessar até ao octante final
+    uint8_t			Finish;			// 1 = eixo maior já atingiu o fim, só faltam as correcções do eixo menor
+    uint8_t			Decel;			// 1 = desaceleração final já pedida
+    uint8_t			StepX, StepY;	// Eixos que dão step no proximo flanco ascendente
+    int8_t				Sign;				// 1 = CCW, -1 = CW
+    int8_t				SX, SY;			// Sentido actual de cada eixo (+1 = dir_CW)
+    int32_t			X, Y;				// Posição actual
+    int32_t			XE, YE;			// Posição final
+    int64_t			F;					// Erro do midpoint: X^2 + Y^2 - R^2
+    int32_t			R;					// Raio
+    uint32_t			Rem;				// Iterações que faltam (estimativa para a desaceleração)
+    uint32_t			AccelSteps;		// Iterações feitas a acelerar, a desaceleração começa quando Rem <= AccelSteps
+    uint32_t			Guard;			// Limite de iterações, protecção contra um fim nunca atingido
+    stphal_tick_t	Delay;			// Meio periodo actual em ticks
+} TArc;
+
+TArc Arc;
+
+// Sentido de X e Y em cada octante no sentido CCW (em CW é o simétrico) e eixo maior de cada octante
+static const int8_t ArcSX[8] 		= {-1, -1, -1, -1,  1,  1,  1,  1};
+static const int8_t ArcSY[8] 		= { 1,  1, -1, -1, -1, -1,  1,  1};
+static const uint8_t ArcMajorY[8]	= { 1,  0,  0,  1,  1,  0,  0,  1};
+#endif
+
+#ifdef STPDRV_USE_SHAPER
+//---- Input shaper struct
+typedef struct {
+    mshaper_t		Type;				// shaper_None, shaper_ZV ou shaper_ZVD
+    uint16_t			Freq;				// Frequência de ressonância em décimas de Hz (como passada a STPDRV_SetShaper)
+    uint16_t			Damping;			// Amortecimento em milésimos
+
+    // control fields - IGNORE THIS FIELDS
+    uint16_t			A[3];				// Amplitude de cada impulso em Q15 (soma = 32768)
+    uint16_t			N[3];				// Atraso de cada impulso em amostras do historico (N[0] = 0)
+    uint16_t			Div;				// Ticks da rampa por amostra do historico (decimação para caber em STPDRV_SHAPER_LEN)
+    uint16_t			DivCnt;
+    uint16_t			Idx;				// Amostra actual em Hist
+    uint16_t			Settle;			// Ticks da rampa que faltam para a saída do shaper estabilizar
+    uint16_t			SettleTicks;		// Valor inicial de Settle sempre que a velocidade comandada muda
+    uint16_t			Hist[STPDRV_SHAPER_LEN];	// Historico da velocidade comandada (TargetCurSpeed)
+} TShaper;
+
+TShaper Shapers[2];
+
+// K = exp(-z.pi / sqrt(1 - z^2)) em Q15 para z = i/32, interpolado em __ShaperCalc (erro < 0.002)
+static const uint16_t ShaperK[33]	= {32768, 29702, 26916, 24377, 22057, 19935, 17989, 16203,
+                                   14560, 13049, 11657, 10376,  9195,  8107,  7106,  6186,
+                                    5342,  4570,  3866,  3226,  2649,  2132,  1674,  1273,
+                                     930,   642,   411,   235,   112,    39,     7,     0,  0};
+#endif
+
+#ifdef STPDRV_USE_TRACE
+//---- Trace, buffer circular de eventos. Idx nunca dá a volta ao buffer, os eventos validos
+//		 são os ultimos STPDRV_TRACE_LEN antes de Idx
+typedef struct {
+    uint32_t			Idx;				// Proximo evento a escrever
+    __IO uint8_t		Enable;			// Se 0 os eventos são ignorados
+    mtrace_rec_t		Buf[STPDRV_TRACE_LEN];
+} TTrace;
+
+TTrace Trace;
+
+// O timestamp é o contador de ciclos do DWT e não o CNT do STPDRV_TIM: o CNT tem 16 bits e dá a
+// volta em 0.33 s, contar as voltas obrigava a ligar a IRQ de update e a ler o UIF com o CNT em
+// cada evento. O CYCCNT tem 32 bits numa só leitura, o Tools/stptrace.c converte em ticks do timer.
+// DWT do Cortex-M3/M4 por endereço, nem todas as versões do CMSIS definem a estrutura do DWT
+#ifndef STPDRV_CYCCNT
+#define STPDRV_DEMCR			(*(__IO uint32_t *) 0xE000EDFC)
+#define STPDRV_DWT_CTRL		(*(__IO uint32_t *) 0xE0001000)
+#define STPDRV_CYCCNT			(*(__IO uint32_t *) 0xE0001004)
+#endif
+
+#define TRACE(ev, mt, data)	__Trace(ev, mt, data)
+#else
+#define TRACE(ev, mt, data)
+#endif
+
+#ifdef STPDRV_USE_RECORD
+//---- Gravação de um movimento. Formato: DIR, meio periodo inicial (u16 little endian, o do
+//		 __MotorOn), um código por cada meio periodo (evento do canal do STEP) e REC_END.
+//		 O pino STEP está sempre LOW no inicio, o primeiro evento é um flanco ascendente
+#define REC_IDLE				0
+#define REC_RECORD			1				// à espera do arranque ou a gravar
+#define REC_DONE				2				// gravação terminada quando o motor parou
+#define REC_OVERFLOW			3				// o buffer encheu, gravação inválida
+#define REC_PLAY				4
+
+#define REC_RUN				0x80			// 0x00-0x7F delta de -64 a 63 ticks, 0x80-0xBF 1 a 64 meio periodos iguais ao anterior
+#define REC_ABS				0xC0			// + u16, meio periodo absoluto
+#define REC_FLIP				0xC1			// inversão do DIR no flanco descendente do evento seguinte
+#define REC_END				0xC2
+#define REC_LRUN				0xC3			// + u16, 1 a 65535 meio periodos iguais ao anterior
+
+typedef struct {
+    uint8_t			*Buf;				// Gravação
+    uint16_t			Size;				// Tamanho do buffer (na reprodução o tamanho da gravação)
+    uint16_t			Len;				// Bytes gravados, na reprodução o proximo byte a ler
+    uint16_t			Last;				// Ultimo meio periodo gravado/reproduzido
+    uint16_t			Run;				// Meio periodos iguais a Last por gravar/por reproduzir
+    mdir_t			Dir;				// Direcção do ultimo meio periodo gravado
+    __IO uint8_t		Mode;				// REC_xxx
+} TRec;
+
+TRec Recs[2];
+#endif
 
 
 //----- Private Function Prototypes - DO NOT USE
@@ -63,58 +238,103 @@ static void 		__MotorSetDir(int16_t mt, mdir_t _dir);
 static void 		__ResetTargetSpeed(int16_t mt);
 static void 		__TargetSpeedDone(int16_t mt);
 static void 		__SetTargetSpeed(int16_t mt, uint16_t _speed, mdir_t _dir, mstate_t _state);
+static void 		__DirPendingFlip(int16_t mt);
+static void 		__UpdateDelay(int16_t mt);
+static void 		__PlanNext(int16_t mt);
+static uint8_t 	__PlanLeg(int16_t mt, uint8_t n, uint16_t _from, uint16_t _to);
+#ifdef STPDRV_USE_BANDS
+static uint16_t 	__BandAdjust(int16_t mt, uint16_t _speed);
+#endif
+#ifdef STPDRV_USE_ARC
+static void 		__OnArcTimer(void);
+static void 		__ArcEnd(void);
+static uint8_t 	__ArcOctant(int32_t x, int32_t y);
+static uint16_t 	__ArcSpeed(int16_t mt);
+#endif
+#if defined(STPDRV_USE_ARC) || defined(STPDRV_USE_SHAPER)
+static uint32_t 	__ISqrt(uint64_t _v);
+#endif
+#ifdef STPDRV_USE_SHAPER
+static void 		__ShaperCalc(int16_t mt);
+static void 		__ShaperReset(int16_t mt, uint16_t _speed);
+static uint16_t 	__ShaperApply(int16_t mt, uint16_t _speed);
+#endif
+#ifdef STPDRV_USE_TRACE
+static __INLINE void __Trace(mtrace_t _ev, int16_t mt, uint16_t _data);
+#endif
+#ifdef STPDRV_USE_RECORD
+static void 		__RecBegin(int16_t mt);
+static void 		__RecPut(int16_t mt, stphal_tick_t _delay);
+static void 		__RecFlush(int16_t mt);
+static void 		__RecByte(int16_t mt, uint8_t _b);
+static void 		__PlayNext(int16_t mt);
+static void 		__StepLow(int16_t mt);
+#endif
+#ifdef STPDRV_USE_ENCODER
+static void 		__InjectStart(int16_t mt);
+#endif
+#ifdef STPDRV_USE_MICROSTEP
+static void 		__MsSelect(int16_t mt, uint16_t _speed);
+static void 		__MsSwitch(int16_t mt);
+static void 		__MsApply(int16_t mt, uint8_t _level);
+static void 		__MsLimit(int16_t mt);
+static uint32_t 	__MsSpeed(int16_t mt);
+static stphal_tick_t __MsDelay(int16_t mt, uint16_t _speed);
+#endif
 static void 		__OnRampTimer(int16_t mt);
-static uint32_t 	__GPIO2AHB1Periph(GPIO_TypeDef *_qual);
 
 //==============================================================================
 //
 void STPDRV_Init(void)
 {
-    GPIO_InitTypeDef 				GPIO_InitStructure;
     NVIC_InitTypeDef 				NVIC_InitStructure;
     TIM_TimeBaseInitTypeDef  	TIM_TimeBaseStructure;
     TIM_OCInitTypeDef  			TIM_OCInitStructure;
 
     SystemCoreClockUpdate();
 
-    //----- GPIO AHB1Periph clock enable
-    /*RCC_AHB1PeriphClockCmd(__GPIO2AHB1Periph(MOTOR1_STEP_PORT) , ENABLE);
-    RCC_AHB1PeriphClockCmd(__GPIO2AHB1Periph(MOTOR1_DIR_PORT)  , ENABLE);
-    RCC_AHB1PeriphClockCmd(__GPIO2AHB1Periph(MOTOR2_STEP_PORT) , ENABLE);
-    RCC_AHB1PeriphClockCmd(__GPIO2AHB1Periph(MOTOR2_DIR_PORT)  , ENABLE);*/
-    RCC_APB2PeriphClockCmd(__GPIO2AHB1Periph(MOTOR1_STEP_PORT) , ENABLE);
-    RCC_APB2PeriphClockCmd(__GPIO2AHB1Periph(MOTOR1_DIR_PORT)  , ENABLE);
-    RCC_APB2PeriphClockCmd(__GPIO2AHB1Periph(MOTOR2_STEP_PORT) , ENABLE);
-    RCC_APB2PeriphClockCmd(__GPIO2AHB1Periph(MOTOR2_DIR_PORT)  , ENABLE);
-
-    // GPIO Configuration - Step PINs & DIR PINs
-    //GPIO_InitStructure.GPIO_Mode = GPIO_Mode_OUT;
-    //GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
-    //GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
-    //GPIO_InitStructure.GPIO_PuPd = GPIO_PuPd_DOWN;
-    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP;
-    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
-
-    GPIO_InitStructure.GPIO_Pin = MOTOR1_STEP_PIN;
-    GPIO_Init(MOTOR1_STEP_PORT, &GPIO_InitStructure);
-    GPIO_InitStructure.GPIO_Pin = MOTOR1_DIR_PIN;
-    GPIO_Init(MOTOR1_DIR_PORT, &GPIO_InitStructure);
-
-    GPIO_InitStructure.GPIO_Pin = MOTOR2_STEP_PIN;
-    GPIO_Init(MOTOR2_STEP_PORT, &GPIO_InitStructure);
-    GPIO_InitStructure.GPIO_Pin = MOTOR2_DIR_PIN;
-    GPIO_Init(MOTOR2_DIR_PORT, &GPIO_InitStructure);
+#ifdef STPDRV_USE_TRACE
+    //----- Contador de ciclos do DWT para o timestamp do trace
+    STPDRV_DEMCR 		|= 0x01000000;		// TRCENA
+    STPDRV_CYCCNT 		= 0;
+    STPDRV_DWT_CTRL 	|= 0x00000001;		// CYCCNTENA
+    Trace.Idx 			= 0;
+    Trace.Enable 		= 1;
+#endif
+
+    //----- GPIO Configuration - Step PINs & DIR PINs (ver stm32f_stphal.h)
+    STPHAL_PinOut(MOTOR1_STEP_PORT, MOTOR1_STEP_PIN);
+    STPHAL_PinOut(MOTOR1_DIR_PORT, MOTOR1_DIR_PIN);
+    STPHAL_PinOut(MOTOR2_STEP_PORT, MOTOR2_STEP_PIN);
+    STPHAL_PinOut(MOTOR2_DIR_PORT, MOTOR2_DIR_PIN);
+#ifdef STPDRV_USE_MICROSTEP
+    STPHAL_PinOut(MOTOR1_MS_PORT, MOTOR1_MS_PINS);
+    STPHAL_PinOut(MOTOR2_MS_PORT, MOTOR2_MS_PINS);
+#endif
 
 
     //----- API struc  INIT (after GPIO init)
-    Motors[0].CurDelay = 0xffff;
+    Motors[0].CurDelay = STPHAL_TICK_MAX;
     __ResetTargetSpeed(0);
     __MotorSetDir(0, dir_CW);
     STPDRV_SetRamp(0, 4);
-    Motors[1].CurDelay = 0xffff;
+    Motors[1].CurDelay = STPHAL_TICK_MAX;
     __MotorSetDir(1, dir_CW);
     __ResetTargetSpeed(1);
     STPDRV_SetRamp(1, 4);
+#ifdef STPDRV_USE_MICROSTEP
+    // o indexador do IC arranca num full step, os dois motores começam na resolução mais fina
+    Micros[0][0].Mul	= 1;
+    Micros[0][0].Pins	= MOTOR1_MS_FINE;
+    Micros[1][0].Mul	= 1;
+    Micros[1][0].Pins	= MOTOR2_MS_FINE;
+    Motors[0].MsMul	= 1;
+    Motors[1].MsMul	= 1;
+    __MsApply(0, 0);
+    __MsApply(1, 0);
+    __MsLimit(0);
+    __MsLimit(1);
+#endif
 
 
     //----- TIM Periph clock enable
@@ -134,7 +354,7 @@ void STPDRV_Init(void)
     //
     // A resolução do sistema é definida em "stm32f_stpdrv.h" no define STPDRV_TIMFREQ
     //
-    TIM_TimeBaseStructure.TIM_Period = 65535;
+    TIM_TimeBaseStructure.TIM_Period = STPHAL_TICK_MAX;		// 32 bits no TIM2/TIM5 do STM32F4
     TIM_TimeBaseStructure.TIM_Prescaler = (uint16_t) ((SystemCoreClock / 2) / (STPDRV_TIMFREQ * 2)) - 1;
     TIM_TimeBaseStructure.TIM_ClockDivision = TIM_CKD_DIV1;
     TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
@@ -169,7 +389,7 @@ void STPDRV_Init(void)
 
 
     // Enable the TIM gloabal Interrupt
-    NVIC_InitStructure.NVIC_IRQChannel = TIM3_IRQn;   // USER EDIT - Mudar o nome do IRQ se o TIMER for alterado
+    NVIC_InitStructure.NVIC_IRQChannel = STPDRV_TIM_IRQn;
     NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = IRQ_STPDRV_PrePriority;
     NVIC_InitStructure.NVIC_IRQChannelSubPriority = IRQ_STPDRV_Priority;
     NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
@@ -186,61 +406,142 @@ void STPDRV_Init(void)
 
 //==============================================================================
 //	descri:   Função para o timer do STEP dos MOTORES
-// USER EDIT - Mudar o nome do IRQ se o TIMER for alterado 
-void TIM3_IRQHandler(void)
+// O nome da IRQ é o STPDRV_TIM_IRQHandler (stm32f_stpdrv.h)
+void STPDRV_TIM_IRQHandler(void)
 {
+#ifdef STPDRV_USE_RECORD
+    stphal_tick_t ccr;
+#endif
+
     // Channel 1 -  MOTOR 1
-    if ((STPDRV_TIM->SR & TIM_IT_CC1) && (STPDRV_TIM->DIER & TIM_IT_CC1)) {
-        STPDRV_TIM->CCR1 += Motors[0].CurDelay;
-        if (MOTOR1_STEP_PORT->IDR & MOTOR1_STEP_PIN) {
-            //MOTOR1_STEP_PORT->BSRRH = MOTOR1_STEP_PIN;
-            MOTOR1_STEP_PORT->BRR = MOTOR1_STEP_PIN;
+#ifdef STPDRV_USE_ARC
+    if (Arc.Active) {
+        // Channel 1 - interpolação circular MOTOR 1 + MOTOR 2
+        if (STPHAL_CC_PENDING(1)) {
+            __OnArcTimer();
+            STPHAL_CC_CLEAR(1);
+        }
+    } else
+#endif
+    if (STPHAL_CC_PENDING(1)) {
+#ifdef STPDRV_USE_RECORD
+        ccr = STPDRV_TIM->CCR1;
+        if (Recs[0].Mode == REC_PLAY)
+            __PlayNext(0);		// meio periodo e inversão do DIR vêm da gravação
+#endif
+#ifdef STPDRV_USE_ENCODER
+        if (Motors[0].InjHalf) {
+            Motors[0].InjHalf--;		// janela do STEP extra, dois STEPs no periodo de um
+            STPHAL_CC_RELOAD(1, Motors[0].CurDelay >> 1);
+        } else
+#endif
+        STPHAL_CC_RELOAD(1, Motors[0].CurDelay);
+#ifdef STPDRV_USE_TRACE
+        if (STPHAL_CC_LATE(1, Motors[0].CurDelay))	// proximo compare já passou, só dá ao fim de uma volta do contador
+            TRACE(trc_Late, 0, (uint16_t) STPHAL_CC_AGE(1));
+#endif
+        if (STPHAL_PIN_READ(MOTOR1_STEP_PORT, MOTOR1_STEP_PIN)) {
+            STPHAL_PIN_RESET(MOTOR1_STEP_PORT, MOTOR1_STEP_PIN);
 #ifdef __STM32F4_DISCOVERY_H
             STM32F4_Discovery_LEDOff(LED3);
 #endif			
+#ifdef STPDRV_USE_MICROSTEP
+            if (Motors[0].MsNext != Motors[0].MsLevel)
+                __MsSwitch(0);		// antes da inversão, o STPDRV_DIRSETUP conta com o CurDelay novo
+#endif
+            if (Motors[0].DirPending)
+                __DirPendingFlip(0);
         } else {
-            //MOTOR1_STEP_PORT->BSRRL = MOTOR1_STEP_PIN;
-            MOTOR1_STEP_PORT->BSRR = MOTOR1_STEP_PIN;
+            STPHAL_PIN_SET(MOTOR1_STEP_PORT, MOTOR1_STEP_PIN);
 #ifdef __STM32F4_DISCOVERY_H
             STM32F4_Discovery_LEDOn(LED3);
 #endif			
+#ifdef STPDRV_USE_ENCODER
+            if (Motors[0].InjHalf == 2) {
+                if (Motors[0].Inject)		// STEP extra, recupera um passo perdido que a posição já contou
+                    Motors[0].Inject--;
+                MS_INJECTED(0);
+            } else
+#endif
             if (Motors[0].Dir == dir_CW)
-                Motors[0].Pos++;
+                Motors[0].Pos += MS_MUL(0);
             else
-                Motors[0].Pos--;
+                Motors[0].Pos -= MS_MUL(0);
+#ifdef STPDRV_USE_ENCODER
+            if (Motors[0].Inject && !Motors[0].InjHalf)
+                __InjectStart(0);
+#endif
         }
-        STPDRV_TIM->SR = ~TIM_IT_CC1;
+#ifdef STPDRV_USE_RECORD
+        if (Recs[0].Mode == REC_RECORD)
+            __RecPut(0, (stphal_tick_t) (STPDRV_TIM->CCR1 - ccr));
+#endif
+        STPHAL_CC_CLEAR(1);
     }
 
     // Channel 2 -  MOTOR 2
-    if ((STPDRV_TIM->SR & TIM_IT_CC2) && (STPDRV_TIM->DIER & TIM_IT_CC2)) {
-        STPDRV_TIM->CCR2 += Motors[1].CurDelay;
-        if (MOTOR2_STEP_PORT->IDR & MOTOR2_STEP_PIN) {
-            //MOTOR2_STEP_PORT->BSRRH = MOTOR2_STEP_PIN;
-            MOTOR2_STEP_PORT->BRR = MOTOR1_STEP_PIN;
+    if (STPHAL_CC_PENDING(2)) {
+#ifdef STPDRV_USE_RECORD
+        ccr = STPDRV_TIM->CCR2;
+        if (Recs[1].Mode == REC_PLAY)
+            __PlayNext(1);		// meio periodo e inversão do DIR vêm da gravação
+#endif
+#ifdef STPDRV_USE_ENCODER
+        if (Motors[1].InjHalf) {
+            Motors[1].InjHalf--;		// janela do STEP extra, dois STEPs no periodo de um
+            STPHAL_CC_RELOAD(2, Motors[1].CurDelay >> 1);
+        } else
+#endif
+        STPHAL_CC_RELOAD(2, Motors[1].CurDelay);
+#ifdef STPDRV_USE_TRACE
+        if (STPHAL_CC_LATE(2, Motors[1].CurDelay))	// proximo compare já passou, só dá ao fim de uma volta do contador
+            TRACE(trc_Late, 1, (uint16_t) STPHAL_CC_AGE(2));
+#endif
+        if (STPHAL_PIN_READ(MOTOR2_STEP_PORT, MOTOR2_STEP_PIN)) {
+            STPHAL_PIN_RESET(MOTOR2_STEP_PORT, MOTOR2_STEP_PIN);
+#ifdef STPDRV_USE_MICROSTEP
+            if (Motors[1].MsNext != Motors[1].MsLevel)
+                __MsSwitch(1);		// antes da inversão, o STPDRV_DIRSETUP conta com o CurDelay novo
+#endif
+            if (Motors[1].DirPending)
+                __DirPendingFlip(1);
         } else {
-            //MOTOR2_STEP_PORT->BSRRL = MOTOR2_STEP_PIN;
-            MOTOR2_STEP_PORT->BSRR = MOTOR2_STEP_PIN;
+            STPHAL_PIN_SET(MOTOR2_STEP_PORT, MOTOR2_STEP_PIN);
+#ifdef STPDRV_USE_ENCODER
+            if (Motors[1].InjHalf == 2) {
+                if (Motors[1].Inject)		// STEP extra, recupera um passo perdido que a posição já contou
+                    Motors[1].Inject--;
+                MS_INJECTED(1);
+            } else
+#endif
             if (Motors[1].Dir == dir_CW)
-                Motors[1].Pos++;
+                Motors[1].Pos += MS_MUL(1);
             else
-                Motors[1].Pos--;
+                Motors[1].Pos -= MS_MUL(1);
+#ifdef STPDRV_USE_ENCODER
+            if (Motors[1].Inject && !Motors[1].InjHalf)
+                __InjectStart(1);
+#endif
         }
-        STPDRV_TIM->SR = ~TIM_IT_CC2;
+#ifdef STPDRV_USE_RECORD
+        if (Recs[1].Mode == REC_RECORD)
+            __RecPut(1, (stphal_tick_t) (STPDRV_TIM->CCR2 - ccr));
+#endif
+        STPHAL_CC_CLEAR(2);
     }
 
     // Channel 3 -  MOTOR 1 ACELL / DECCEL
-    if ((STPDRV_TIM->SR & TIM_IT_CC3) && (STPDRV_TIM->DIER & TIM_IT_CC3)) {
-        STPDRV_TIM->CCR3 += Motors[0].RampDelay;
+    if (STPHAL_CC_PENDING(3)) {
+        STPHAL_CC_RELOAD(3, Motors[0].RampDelay);
         __OnRampTimer(0);
-        STPDRV_TIM->SR = ~TIM_IT_CC3;
+        STPHAL_CC_CLEAR(3);
     }
 
     // Channel 4 -  MOTOR 2 ACELL / DECCEL
-    if ((STPDRV_TIM->SR & TIM_IT_CC4) && (STPDRV_TIM->DIER & TIM_IT_CC4)) {
-        STPDRV_TIM->CCR4 += Motors[1].RampDelay;
+    if (STPHAL_CC_PENDING(4)) {
+        STPHAL_CC_RELOAD(4, Motors[1].RampDelay);
         __OnRampTimer(1);
-        STPDRV_TIM->SR = ~TIM_IT_CC4;
+        STPHAL_CC_CLEAR(4);
     }
 }
 //==============================================================================
@@ -253,17 +554,300 @@ void STPDRV_SetRamp(int16_t motor, int16_t rampspeed)
     // um numero maior faz com que a rampa seja mais brusca
 
     Motors[motor].RampDelay = (STPDRV_TIMFREQ * 2) / (rampspeed / Motors[motor].RampSlop);
+#ifdef STPDRV_USE_SHAPER
+    __ShaperCalc(motor);		// os atrasos dos impulsos dependem do periodo da rampa
+#endif
+}
+//==============================================================================
+
+#ifdef STPDRV_USE_SHAPER
+//==============================================================================
+//
+int16_t STPDRV_SetShaper(int16_t motor, mshaper_t type, uint16_t freq, uint16_t damping)
+{
+    Shapers[motor].Type = shaper_None;
+    Shapers[motor].Settle = 0;
+    if ((type != shaper_None) && ((freq == 0) || (damping >= 1000)))
+        return 0;
+
+    // o historico tem de ter a velocidade actual, o shaper pode ser ligado com a rampa a correr
+    __ShaperReset(motor, Motors[motor].TargetCurSpeed ? Motors[motor].TargetCurSpeed
+                  : (uint16_t) (CUR_SPEED(motor) + 1));
+    Shapers[motor].Freq = freq;
+    Shapers[motor].Damping = damping;
+    Shapers[motor].Type = type;
+    __ShaperCalc(motor);
+    return (Shapers[motor].Type == type);
 }
 //==============================================================================
+#endif
+
+#ifdef STPDRV_USE_BANDS
+//==============================================================================
+//
+int16_t STPDRV_SetBand(int16_t motor, int16_t band, uint16_t low, uint16_t high, uint16_t slopmul)
+{
+    int16_t i;
+
+    if ((band < 0) || (band >= STPDRV_MAXBANDS))
+        return 0;
+    if (high != 0) {
+        if ((low >= high) || (slopmul == 0) || ((uint32_t) Motors[motor].RampSlop * slopmul > low))
+            return 0;		// um slope maior que low passava por baixo de zero na desaceleração
+        if ((low < STPDRV_STARTSTOPSEC) && (high > STPDRV_STARTSTOPSEC))
+            return 0;		// a inversão e a paragem passam em cruzeiro pela velocidade de arranque/paragem
+        for (i = 0; i < STPDRV_MAXBANDS; i++) {
+            if ((i == band) || (Bands[motor][i].High == 0))
+                continue;
+            if ((i < band) ? (Bands[motor][i].High > low) : (Bands[motor][i].Low < high))
+                return 0;		// fora de ordem ou sobreposta
+        }
+    }
+    Bands[motor][band].Low 		= low;
+    Bands[motor][band].High 	= high;
+    Bands[motor][band].SlopMul	= slopmul;
+    return 1;
+}
+//==============================================================================
+#endif
 
 //==============================================================================
 //
 void STPDRV_Move(int16_t motor, mdir_t direction, int16_t speed)
 {
+#ifdef STPDRV_USE_ARC
+    if (Arc.Active)
+        return;
+#endif
     __SetTargetSpeed(motor, speed, direction, mstat_Move);
 }
 //==============================================================================
 
+#ifdef STPDRV_USE_ARC
+//==============================================================================
+//
+int16_t STPDRV_Arc(int32_t cx, int32_t cy, int32_t ex, int32_t ey, mdir_t dir, int16_t speed)
+{
+    int32_t r, ms, me, b;
+    uint8_t oe;
+    int64_t c;
+
+    if ((Arc.Active) || (STPDRV_TIM->DIER & (TIM_IT_CC1 | TIM_IT_CC2)))
+        return 0;		// os dois motores têm de estar parados
+    if ((speed < STPDRV_MINSETPSEC) || (speed > STPDRV_MAXSETPSEC) || (dir == dir_ANY))
+        return 0;
+
+    Arc.X 	= Motors[0].Pos - cx;
+    Arc.Y 	= Motors[1].Pos - cy;
+    Arc.XE 	= ex - cx;
+    Arc.YE 	= ey - cy;
+    r = (int32_t) __ISqrt((uint64_t) ((int64_t) Arc.X * Arc.X + (int64_t) Arc.Y * Arc.Y));
+    if (r == 0)
+        return 0;
+    Arc.F 		= (int64_t) Arc.X * Arc.X + (int64_t) Arc.Y * Arc.Y - (int64_t) r * r;
+    Arc.R		= r;
+    Arc.Sign 	= (dir == dir_CCW) ? 1 : -1;
+
+    // numero de fronteiras de octante a atravessar, o ponto final no mesmo octante mas para trás
+    // (ou igual ao inicial) dá uma volta completa
+    Arc.Oct = __ArcOctant(Arc.X, Arc.Y);
+    oe = __ArcOctant(Arc.XE, Arc.YE);
+    Arc.Cross = (uint8_t) ((Arc.Sign > 0 ? oe - Arc.Oct : Arc.Oct - oe) & 7);
+    c = (int64_t) Arc.X * Arc.YE - (int64_t) Arc.Y * Arc.XE;
+    if ((Arc.Cross == 0) && ((Arc.Sign > 0) ? (c <= 0) : (c >= 0)))
+        Arc.Cross = 8;
+
+    // estimativa do numero de iterações: em cada octante o eixo maior avança 1 step por iteração
+    // e varia entre 0 (nos eixos) e b = R/sqrt(2) (nas diagonais)
+    b  = (int32_t) __ISqrt((uint64_t) r * r / 2);
+    ms = ArcMajorY[Arc.Oct] ? Arc.Y : Arc.X;
+    me = ArcMajorY[oe] ? Arc.YE : Arc.XE;
+    ms = ms < 0 ? -ms : ms;
+    me = me < 0 ? -me : me;
+    if (Arc.Cross == 0)
+        Arc.Rem = (uint32_t) (ms > me ? ms - me : me - ms);
+    else {
+        // CCW sai dos octantes pares pela diagonal, CW dos impares, a entrada no octante final é pela outra fronteira
+        ms = (((Arc.Oct & 1) == 0) == (Arc.Sign > 0)) ? b - ms : ms;
+        me = (((oe & 1) == 0) == (Arc.Sign > 0)) ? me : b - me;
+        Arc.Rem = (uint32_t) ((ms > 0 ? ms : 0) + (me > 0 ? me : 0)) + (uint32_t) (Arc.Cross - 1) * (uint32_t) b;
+    }
+    Arc.Guard 		= Arc.Rem + (Arc.Rem >> 3) + 16;
+    Arc.AccelSteps	= 0;
+    Arc.Finish		= 0;
+    Arc.Decel		= 0;
+    Arc.Phase		= 0;
+    Arc.StepX		= 0;
+    Arc.StepY		= 0;
+    Arc.SX			= 0;
+    Arc.SY			= 0;
+
+    // os dois STEP começam em baixo, o primeiro evento decide o primeiro movimento
+    STPHAL_PIN_RESET(MOTOR1_STEP_PORT, MOTOR1_STEP_PIN);
+    STPHAL_PIN_RESET(MOTOR2_STEP_PORT, MOTOR2_STEP_PIN);
+    __MotorOff(1);
+    Arc.Active = 1;
+
+    // a rampa do MOTOR1 dá a velocidade tangencial
+    __SetTargetSpeed(0, speed, Motors[0].Dir, mstat_Arc);
+    Motors[0].State = mstat_Arc;
+    Motors[1].State = mstat_Arc;
+    return 1;
+}
+//==============================================================================
+#endif
+
+#ifdef STPDRV_USE_ENCODER
+//==============================================================================
+//
+void STPDRV_Inject(int16_t motor, uint16_t steps)
+{
+#ifdef STPDRV_USE_MICROSTEP
+    steps /= Motors[motor].MsMul;		// STEPs na resolução actual
+#endif
+    Motors[motor].Inject = steps;
+}
+//==============================================================================
+#endif
+
+#ifdef STPDRV_USE_MICROSTEP
+//==============================================================================
+//
+int16_t STPDRV_SetMicrostep(int16_t motor, int16_t level, uint16_t mul, uint16_t pins, uint16_t up, uint16_t down)
+{
+    TMicro *prev;
+
+    if ((level < 0) || (level >= STPDRV_MS_LEVELS) || (STPDRV_GetSpeed(motor) != 0) || (Motors[motor].MsLevel != 0))
+        return 0;
+    if (pins & ~(motor == (int16_t) 0x0 ? MOTOR1_MS_PINS : MOTOR2_MS_PINS))
+        return 0;
+    if (level == 0) {
+        Micros[motor][0].Pins = pins;
+        __MsApply(motor, 0);
+        return 1;
+    }
+    if (mul != 0) {
+        prev = &Micros[motor][level - 1];
+        if ((prev->Mul == 0) || (mul <= prev->Mul) || (STPDRV_MS_FULL % mul) || (up <= down))
+            return 0;
+        if ((level + 1 < STPDRV_MS_LEVELS) && Micros[motor][level + 1].Mul && (Micros[motor][level + 1].Mul <= mul))
+            return 0;		// fora de ordem
+        if ((up > (uint32_t) STPDRV_MAXSETPSEC * prev->Mul) || ((uint32_t) down * 65535 < (uint32_t) STPDRV_TIMFREQ * mul))
+            return 0;		// o nivel anterior passava STPDRV_MAXSETPSEC ou o CurDelay não cabe em 16 bits
+    }
+    Micros[motor][level].Mul	= mul;
+    Micros[motor][level].Pins	= pins;
+    Micros[motor][level].Up		= up;
+    Micros[motor][level].Down	= down;
+    __MsLimit(motor);
+    return 1;
+}
+//==============================================================================
+#endif
+
+#ifdef STPDRV_USE_RECORD
+//==============================================================================
+//
+int16_t STPDRV_RecStart(int16_t motor, uint8_t *buf, uint16_t size)
+{
+    if ((STPDRV_GetSpeed(motor) != 0) || (size < 4))
+        return 0;
+    __StepLow(motor);
+    Recs[motor].Buf		= buf;
+    Recs[motor].Size	= size;
+    Recs[motor].Len		= 0;
+    Recs[motor].Run		= 0;
+    Recs[motor].Mode	= REC_RECORD;
+    return 1;
+}
+//==============================================================================
+
+//==============================================================================
+//
+uint16_t STPDRV_RecEnd(int16_t motor)
+{
+    uint16_t len = 0;
+
+    if ((Recs[motor].Mode == REC_RECORD) && (STPDRV_GetSpeed(motor) != 0))
+        return 0;			// só termina quando o motor parar
+    if (Recs[motor].Mode == REC_DONE)
+        len = Recs[motor].Len;
+    if (Recs[motor].Mode != REC_PLAY)
+        Recs[motor].Mode = REC_IDLE;
+    return len;
+}
+//==============================================================================
+
+//==============================================================================
+//
+int16_t STPDRV_Replay(int16_t motor, const uint8_t *buf, uint16_t len)
+{
+    if ((STPDRV_GetSpeed(motor) != 0) || (len < 4) || (buf[0] > dir_CCW) || (buf[len - 1] != REC_END))
+        return 0;
+#ifdef STPDRV_USE_ARC
+    if (Arc.Active)
+        return 0;
+#endif
+    if (buf[3] == REC_END)
+        return 1;			// gravação sem nenhum STEP
+
+    __ResetTargetSpeed(motor);
+    __StepLow(motor);
+    __MotorSetDir(motor, (mdir_t) buf[0]);
+    Recs[motor].Buf		= (uint8_t *) buf;
+    Recs[motor].Size	= len;
+    Recs[motor].Len		= 3;
+    Recs[motor].Run		= 0;
+    Recs[motor].Last	= (uint16_t) (buf[1] | (buf[2] << 8));
+    Recs[motor].Mode	= REC_PLAY;
+    Motors[motor].CurDelay	= Recs[motor].Last;
+    Motors[motor].State		= mstat_Move;
+    __MotorOn(motor);
+    return 1;
+}
+//==============================================================================
+
+#endif
+
+#ifdef STPDRV_USE_TRACE
+//==============================================================================
+//
+void STPDRV_TraceEnable(int16_t enable)
+{
+    Trace.Enable = enable ? 1 : 0;
+}
+//==============================================================================
+
+//==============================================================================
+//
+uint16_t STPDRV_TraceCount(void)
+{
+    return (uint16_t) (Trace.Idx < STPDRV_TRACE_LEN ? Trace.Idx : STPDRV_TRACE_LEN);
+}
+//==============================================================================
+
+//==============================================================================
+//
+uint16_t STPDRV_TraceDump(mtrace_rec_t *dst, uint16_t first, uint16_t max)
+{
+    uint32_t oldest = Trace.Idx - STPDRV_TraceCount();
+    uint16_t n;
+
+    for (n = 0; (n < max) && ((uint16_t) (first + n) < STPDRV_TraceCount()); n++)
+        dst[n] = Trace.Buf[(oldest + first + n) & (STPDRV_TRACE_LEN - 1)];
+    return n;
+}
+//==============================================================================
+
+//==============================================================================
+//
+void STPDRV_TraceClear(void)
+{
+    Trace.Idx = 0;
+}
+//==============================================================================
+#endif
+
 //==============================================================================
 //
 void STPDRV_Goto(int16_t motor, int32_t position, int16_t speed, mdir_t movedir)
@@ -274,10 +858,17 @@ void STPDRV_Goto(int16_t motor, int32_t position, int16_t speed, mdir_t movedir)
 
 //==============================================================================
 //
-void TPDRV_Stop(int16_t motor, int16_t hardstop)
+void STPDRV_Stop(int16_t motor, int16_t hardstop)
 {
-    if (hardstop)
-        __SetTargetSpeed(motor, STPDRV_MINSETPSEC, Motors[motor].Dir, mstat_Stop);
+#ifdef STPDRV_USE_ARC
+    if (Arc.Active) {
+        __ArcEnd();		// um arco é sempre parado de imediato
+        return;
+    }
+#endif
+    // desacelera até à velocidade de arranque/paragem, se já estiver abaixo dela pára logo
+    if ((!hardstop) && (CUR_SPEED(motor) > STPDRV_STARTSTOPSEC))
+        __SetTargetSpeed(motor, STPDRV_STARTSTOPSEC, Motors[motor].Dir, mstat_Stop);
     else {
         __ResetTargetSpeed(motor);
         __MotorOff(motor);
@@ -294,6 +885,58 @@ int32_t 	STPDRV_GetPos(int16_t motor)
 }
 //==============================================================================
 
+//==============================================================================
+//
+void 	STPDRV_SetPos(int16_t motor, int32_t position)
+{
+#ifdef STPDRV_USE_MICROSTEP
+    Motors[motor].MsOrg += position - Motors[motor].Pos;		// o indexador do IC não mexe
+#endif
+    Motors[motor].Pos = position;
+}
+//==============================================================================
+
+//==============================================================================
+//
+uint16_t 	STPDRV_GetSpeed(int16_t motor)
+{
+#ifdef STPDRV_USE_ARC
+    if (Arc.Active)
+        return __ArcSpeed(motor);		// no arco o canal do MOTOR2 está desligado
+#endif
+    if ((STPDRV_TIM->DIER & (motor == (int16_t) 0x0 ? TIM_IT_CC1 : TIM_IT_CC2)) == (uint16_t) 0x0)
+        return 0;
+    return (uint16_t) CUR_SPEED(motor);
+}
+//==============================================================================
+
+//==============================================================================
+//
+uint16_t 	STPDRV_GetMaxSpeed(int16_t motor)
+{
+    return MAX_SPEED(motor);
+}
+//==============================================================================
+
+//==============================================================================
+//
+void 	STPDRV_GetStatus(int16_t motor, mstatus_t *status)
+{
+    status->Pos			= Motors[motor].Pos;
+    status->RampSpeed	= Motors[motor].TargetCurSpeed;
+    status->CurDelay	= STPHAL_TICK16(Motors[motor].CurDelay);
+    status->State		= Motors[motor].State;
+    status->Dir			= Motors[motor].Dir;
+#ifdef STPDRV_USE_ARC
+    if (Arc.Active) {
+        // a rampa e o CurDelay são os do MOTOR1 (velocidade tangencial), dá os de cada eixo
+        status->RampSpeed	= __ArcSpeed(motor);
+        status->CurDelay	= (status->RampSpeed > STPDRV_TIMFREQ / 0xFFFF) ? (uint16_t) (STPDRV_TIMFREQ / status->RampSpeed) : 0xFFFF;
+    }
+#endif
+}
+//==============================================================================
+
 //==============================================================================
 //
 mdir_t  	STPDRV_GetDir(int16_t motor)
@@ -315,28 +958,51 @@ mstate_t	STPDRV_GetState(int16_t motor)
 static void __MotorOff(int16_t mt)
 {
     if (mt == (int16_t) 0x0)
-        STPDRV_TIM->DIER &= ~TIM_IT_CC1;
+        STPHAL_CC_STOP(1);
     else
-        STPDRV_TIM->DIER &= ~TIM_IT_CC2;
-    Motors[mt].CurDelay	= 0xFFFF;
+        STPHAL_CC_STOP(2);
+#ifdef STPDRV_USE_MICROSTEP
+    if (Motors[mt].MsLevel != 0)
+        __MsApply(mt, 0);		// parado, passar a uma resolução mais fina não precisa de esperar pelo full step
+    Motors[mt].MsNext	= 0;
+#endif
+    Motors[mt].CurDelay	= STPHAL_TICK_MAX;
+#ifdef STPDRV_USE_ENCODER
+    Motors[mt].Inject	= 0;
+    Motors[mt].InjHalf	= 0;
+#endif
+#ifdef STPDRV_USE_RECORD
+    if ((Recs[mt].Mode == REC_RECORD) && Recs[mt].Len) {
+        __RecFlush(mt);
+        __RecByte(mt, REC_END);
+        if (Recs[mt].Mode == REC_RECORD)
+            Recs[mt].Mode = REC_DONE;
+    } else if (Recs[mt].Mode == REC_PLAY)
+        Recs[mt].Mode = REC_IDLE;
+#endif
+    TRACE(trc_MotorOff, mt, (uint16_t) Motors[mt].Pos);
 
     // USER EDIT - Add your stepper IC disable command here
 }
 //
 static void __MotorOn(int16_t mt)
 {
+#ifdef STPDRV_USE_RECORD
+    if ((Recs[mt].Mode == REC_RECORD) && ((STPDRV_TIM->DIER & (mt == (int16_t) 0x0 ? TIM_IT_CC1 : TIM_IT_CC2)) == (uint16_t) 0x0))
+        __RecBegin(mt);
+#endif
     if (mt == (int16_t) 0x0) {
         if ((STPDRV_TIM->DIER & TIM_IT_CC1) == (uint16_t) 0x0) {
-            STPDRV_TIM->CCR1  = STPDRV_TIM->CNT + Motors[mt].CurDelay;
-            STPDRV_TIM->DIER |= TIM_IT_CC1;
+            STPHAL_CC_ARM(1, Motors[mt].CurDelay);
+            TRACE(trc_MotorOn, mt, STPHAL_TICK16(Motors[mt].CurDelay));
             // A proxima linha força um IRQ se for necessário um arranque imediato, depende em parte do IC do driver usado.
             //STPDRV_TIM->EGR	= TIM_EGR_CC1G;
 
             // USER EDIT - Add your stepper IC enable command here
         }
     } else if ((STPDRV_TIM->DIER & TIM_IT_CC2) == (uint16_t) 0x0) {
-        STPDRV_TIM->CCR2  = STPDRV_TIM->CNT + Motors[mt].CurDelay;
-        STPDRV_TIM->DIER |= TIM_IT_CC2;
+        STPHAL_CC_ARM(2, Motors[mt].CurDelay);
+        TRACE(trc_MotorOn, mt, STPHAL_TICK16(Motors[mt].CurDelay));
         // A proxima linha força um IRQ se for necessário um arranque imediato, depende em parte do IC do driver usado.
         //STPDRV_TIM->EGR	= TIM_EGR_CC2G;
 
@@ -351,20 +1017,20 @@ static void __MotorSetDir(int16_t mt, mdir_t _dir)
 {
     if (_dir == dir_CCW) {
         if (mt == (int16_t) 0x0)
-            //MOTOR1_DIR_PORT->BSRRH = MOTOR1_DIR_PIN;
-            MOTOR1_DIR_PORT->BRR = MOTOR1_DIR_PIN;
+            STPHAL_PIN_RESET(MOTOR1_DIR_PORT, MOTOR1_DIR_PIN);
         else
-            //MOTOR2_DIR_PORT->BSRRH = MOTOR2_DIR_PIN;
-            MOTOR2_DIR_PORT->BRR = MOTOR2_DIR_PIN;
+            STPHAL_PIN_RESET(MOTOR2_DIR_PORT, MOTOR2_DIR_PIN);
     } else {
         if (mt == (int16_t) 0x0)
-            //MOTOR1_DIR_PORT->BSRRL = MOTOR1_DIR_PIN;
-            MOTOR1_DIR_PORT->BSRR = MOTOR1_DIR_PIN;
+            STPHAL_PIN_SET(MOTOR1_DIR_PORT, MOTOR1_DIR_PIN);
         else
-            //MOTOR2_DIR_PORT->BSRRL = MOTOR2_DIR_PIN;
-            MOTOR2_DIR_PORT->BSRR = MOTOR2_DIR_PIN;
+            STPHAL_PIN_SET(MOTOR2_DIR_PORT, MOTOR2_DIR_PIN);
     }
     Motors[mt].Dir = _dir;
+#ifdef STPDRV_USE_ENCODER
+    Motors[mt].Inject = 0;			// a correcção pendente era no sentido antigo
+    Motors[mt].InjHalf = 0;
+#endif
 }
 //==============================================================================
 
@@ -373,13 +1039,16 @@ static void __MotorSetDir(int16_t mt, mdir_t _dir)
 static void __ResetTargetSpeed(int16_t mt)
 {
     if (mt == (int16_t) 0x0)
-        STPDRV_TIM->DIER &= ~TIM_IT_CC3;
+        STPHAL_CC_STOP(3);
     else
-        STPDRV_TIM->DIER &= ~TIM_IT_CC4;
+        STPHAL_CC_STOP(4);
     Motors[mt].TargetSpeed		= 0;
-    Motors[mt].TargetSpeed2		= 0;
     Motors[mt].TargetCurSpeed	= 0;
     Motors[mt].TargetState		= mstat_Stop;
+    Motors[mt].DirPending		= 0;
+    Motors[mt].PlanIdx			= 0;
+    Motors[mt].PlanLen			= 0;
+    Motors[mt].PlanSpeed		= 0;
 }
 //==============================================================================
 
@@ -387,12 +1056,13 @@ static void __ResetTargetSpeed(int16_t mt)
 // 
 static void __TargetSpeedDone(int16_t mt)
 {
-    if (Motors[mt].TargetSpeed2 > 0) {
-        __MotorSetDir(mt, Motors[mt].Dir == dir_CW ? dir_CCW : dir_CW);
-        Motors[mt].TargetSpeed = Motors[mt].TargetSpeed2;
-        Motors[mt].TargetSpeed2 = 0;
+    if (Motors[mt].PlanIdx < Motors[mt].PlanLen) {
+        // o proximo segmento é uma inversão (os outros são carregados em __OnRampTimer), a inversão do
+        // DIR e a passagem ao segmento seguinte são feitas no proximo flanco descendente do STEP
+        Motors[mt].DirPending = 1;
     } else {
         Motors[mt].State = Motors[mt].TargetState;
+        TRACE(trc_Done, mt, Motors[mt].State);
         __ResetTargetSpeed(mt);
 
         if ((Motors[mt].State == mstat_Stop) || (Motors[mt].CurDelay == 0))
@@ -412,99 +1082,895 @@ static void __TargetSpeedDone(int16_t mt)
 //
 static void __SetTargetSpeed(int16_t mt, uint16_t _speed, mdir_t _dir, mstate_t _state)
 {
-    if ((_speed < STPDRV_MINSETPSEC) || (_speed > STPDRV_MAXSETPSEC))
+    uint8_t n = 0;
+    uint16_t stop;
+
+    if ((_speed < STPDRV_MINSETPSEC) || (_speed > MAX_SPEED(mt)))
         return;
+#ifdef STPDRV_USE_BANDS
+    _speed = __BandAdjust(mt, _speed);		// nunca ficar em cruzeiro dentro de uma banda de ressonância
+#endif
 
     // para evitar multiplas reentradas
-    if ((Motors[mt].TargetSpeed==_speed) && (Motors[mt].TargetState==_state) && (Motors[mt].Dir==_dir))
+    if ((Motors[mt].PlanSpeed==_speed) && (Motors[mt].TargetState==_state) && (Motors[mt].Dir==_dir))
         return;
+#ifdef STPDRV_USE_RECORD
+    if (Recs[mt].Mode == REC_PLAY)
+        Recs[mt].Mode = REC_IDLE;		// a rampa continua a partir do meio periodo actual
+#endif
+    TRACE(trc_Cmd, mt, _speed);
 
-    // se direcção actual for diferente então parar o motor primeiro, TargetSpeed2 será executado depois
-    if (Motors[mt].Dir != _dir) {
-        Motors[mt].TargetSpeed 	= STPDRV_MINSETPSEC;  // para evitar o stall do motor
-        Motors[mt].TargetSpeed2	= _speed;
-    } else {
+    // se o motor estiver parado não há nada para inverter, arranca logo à velocidade de arranque/paragem
+    if ((STPDRV_TIM->DIER & (mt == (int16_t) 0x0 ? TIM_IT_CC1 : TIM_IT_CC2)) == (uint16_t) 0x0) {
         __MotorSetDir(mt, _dir);
-        Motors[mt].TargetSpeed 	= _speed;
-        Motors[mt].TargetSpeed2	= 0;
+        Motors[mt].CurDelay = SPEED2DELAY(mt, (_speed < STPDRV_STARTSTOPSEC ? _speed : STPDRV_STARTSTOPSEC));
+    }
+    // se a rampa estiver a correr TargetCurSpeed já é a velocidade comandada (com o shaper pode ser diferente
+    // da velocidade real dada por CurDelay), senão parte da velocidade actual
+    if ((STPDRV_TIM->DIER & (mt == (int16_t) 0x0 ? TIM_IT_CC3 : TIM_IT_CC4)) == (uint16_t) 0x0) {
+        Motors[mt].TargetCurSpeed = CUR_SPEED(mt) + 1;  	// dá os steps/sec actuais
+#ifdef STPDRV_USE_SHAPER
+        __ShaperReset(mt, Motors[mt].TargetCurSpeed);
+#endif
     }
 
+    // planear a rampa: se direcção actual for diferente então desacelerar até à velocidade de arranque/paragem
+    // (nunca acelerar no sentido antigo), inverter o DIR e acelerar logo a seguir até _speed
+    if (Motors[mt].Dir != _dir) {
+        stop = Motors[mt].TargetCurSpeed < STPDRV_STARTSTOPSEC ? Motors[mt].TargetCurSpeed : STPDRV_STARTSTOPSEC;
+        n = __PlanLeg(mt, n, Motors[mt].TargetCurSpeed, stop);
+        Motors[mt].Plan[n].Speed	= 0;
+        Motors[mt].Plan[n++].Slop	= 0;
+        n = __PlanLeg(mt, n, stop, _speed);
+    } else
+        n = __PlanLeg(mt, n, Motors[mt].TargetCurSpeed, _speed);
+
+    Motors[mt].DirPending	= 0;
+    Motors[mt].PlanLen		= n;
+    Motors[mt].PlanIdx		= 0;
+    Motors[mt].PlanSpeed	= _speed;
+    __PlanNext(mt);
+
     Motors[mt].TargetState = _state;
-    Motors[mt].TargetCurSpeed = (STPDRV_TIMFREQ / Motors[mt].CurDelay) + 1;  	// dá os steps/sec actuais
 
     __MotorOn(mt);
     if (mt == (int16_t) 0x0) {
-        if ((STPDRV_TIM->DIER & TIM_IT_CC3) == (uint16_t) 0x0) {		// só se estiver mesmo desligado
-            STPDRV_TIM->DIER |= TIM_IT_CC3;
-            STPDRV_TIM->CCR3 	= STPDRV_TIM->CNT; 	// + RampDelay
-            STPDRV_TIM->EGR 	= TIM_EGR_CC3G;  		// forçar um Interrupt
+        if ((STPDRV_TIM->DIER & TIM_IT_CC3) == (uint16_t) 0x0)		// só se estiver mesmo desligado
+            STPHAL_CC_FORCE(3);		// forçar um Interrupt
+    } else {
+        if ((STPDRV_TIM->DIER & TIM_IT_CC4) == (uint16_t) 0x0)		// só se estiver mesmo desligado
+            STPHAL_CC_FORCE(4);		// forçar um Interrupt
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Inverte a direcção pendente de uma inversão de sentido. É chamada na IRQ do STEP logo
+//				após o flanco descendente, o proximo flanco ascendente fica a pelo menos STPDRV_DIRSETUP
+//				ticks da mudança do DIR. A rampa continua de imediato com o segmento seguinte
+//	params:	mt - motor
+//	return:	nada
+//
+static void __DirPendingFlip(int16_t mt)
+{
+    __MotorSetDir(mt, Motors[mt].Dir == dir_CW ? dir_CCW : dir_CW);
+    TRACE(trc_DirFlip, mt, Motors[mt].Dir);
+#ifdef STPDRV_USE_RECORD
+    if (Recs[mt].Mode == REC_PLAY) {
+        Motors[mt].DirPending = 0;		// o meio periodo gravado já inclui o STPDRV_DIRSETUP
+        return;
+    }
+#endif
+    if (Motors[mt].CurDelay < STPDRV_DIRSETUP) {
+        if (mt == (int16_t) 0x0)
+            STPHAL_CC_RELOAD(1, STPDRV_DIRSETUP - Motors[mt].CurDelay);
+        else
+            STPHAL_CC_RELOAD(2, STPDRV_DIRSETUP - Motors[mt].CurDelay);
+    }
+#ifdef STPDRV_USE_SHAPER
+    // o historico do shaper tem velocidades do sentido antigo, que não se podem misturar com as do
+    // sentido novo: recomeça com a velocidade de inversão como se o motor arrancasse parado
+    if (Shapers[mt].Type != shaper_None) {
+        __ShaperReset(mt, Motors[mt].TargetCurSpeed);
+        Motors[mt].CurDelay = SPEED2DELAY(mt, Motors[mt].TargetCurSpeed);
+    }
+#endif
+    Motors[mt].DirPending	= 0;
+    Motors[mt].PlanIdx++;		// salta o segmento da inversão
+    __PlanNext(mt);
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Carrega o proximo segmento do plano da rampa em TargetSpeed/CurSlop
+//	params:	mt - motor
+//	return:	nada
+//
+static void __PlanNext(int16_t mt)
+{
+    if (Motors[mt].PlanIdx < Motors[mt].PlanLen) {
+        Motors[mt].TargetSpeed	= Motors[mt].Plan[Motors[mt].PlanIdx].Speed;
+        Motors[mt].CurSlop		= Motors[mt].Plan[Motors[mt].PlanIdx].Slop;
+        Motors[mt].PlanIdx++;
+        TRACE(trc_Segment, mt, Motors[mt].TargetSpeed);
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Acrescenta ao plano os segmentos para ir de uma velocidade a outra. Com bandas de
+//				ressonância, cada banda atravessada é dividida num segmento até à entrada da banda ao
+//				RampSlop normal e outro até à saída com o RampSlop multiplicado por SlopMul
+//	params:	mt - motor
+//          n - primeiro segmento livre do plano
+//          from - velocidade de partida em steps/sec
+//          to - velocidade a atingir em steps/sec
+//	return:	proximo segmento livre do plano
+//
+static uint8_t __PlanLeg(int16_t mt, uint8_t n, uint16_t _from, uint16_t _to)
+{
+#ifdef STPDRV_USE_BANDS
+    TBand *bd = Bands[mt];
+    int16_t i;
+
+    if (_to > _from) {
+        for (i = 0; i < STPDRV_MAXBANDS; i++) {
+            if ((bd[i].High == 0) || (bd[i].High <= _from) || (bd[i].Low >= _to))
+                continue;
+            if (bd[i].Low > _from) {
+                Motors[mt].Plan[n].Speed	= bd[i].Low;
+                Motors[mt].Plan[n++].Slop	= Motors[mt].RampSlop;
+            }
+            Motors[mt].Plan[n].Speed	= bd[i].High < _to ? bd[i].High : _to;
+            Motors[mt].Plan[n++].Slop	= Motors[mt].RampSlop * bd[i].SlopMul;
         }
     } else {
-        if ((STPDRV_TIM->DIER & TIM_IT_CC4) == (uint16_t) 0x0) {		// só se estiver mesmo desligado
-            STPDRV_TIM->DIER |= TIM_IT_CC4;
-            STPDRV_TIM->CCR4  = STPDRV_TIM->CNT;	// + RampDelay;
-            STPDRV_TIM->EGR 	= TIM_EGR_CC4G;  		// forçar um Interrupt
+        for (i = STPDRV_MAXBANDS - 1; i >= 0; i--) {
+            if ((bd[i].High == 0) || (bd[i].Low >= _from) || (bd[i].High <= _to))
+                continue;
+            if (bd[i].High < _from) {
+                Motors[mt].Plan[n].Speed	= bd[i].High;
+                Motors[mt].Plan[n++].Slop	= Motors[mt].RampSlop;
+            }
+            Motors[mt].Plan[n].Speed	= bd[i].Low > _to ? bd[i].Low : _to;
+            Motors[mt].Plan[n++].Slop	= Motors[mt].RampSlop * bd[i].SlopMul;
         }
     }
+#endif
+    Motors[mt].Plan[n].Speed	= _to;
+    Motors[mt].Plan[n++].Slop	= Motors[mt].RampSlop;
+    return n;
 }
 //==============================================================================
 
+#ifdef STPDRV_USE_BANDS
 //==============================================================================
+//	descri:  Se a velocidade estiver dentro de uma banda de ressonância muda-a para o limite mais
+//				proximo da banda (o inferior em caso de empate ou se o superior passar a velocidade maxima)
+//	params:	mt - motor
+//          speed - velocidade de cruzeiro pedida em steps/sec
+//	return:	velocidade de cruzeiro a usar
 //
-static uint32_t __GPIO2AHB1Periph(GPIO_TypeDef *_qual)
+static uint16_t __BandAdjust(int16_t mt, uint16_t _speed)
 {
-    uint32_t ret = (uint32_t) 0x00;
+    int16_t i;
 
-    if (_qual == GPIOA)
-        //ret = RCC_AHB1Periph_GPIOA;
-        ret = RCC_APB2Periph_GPIOA;
-    else if (_qual == GPIOB)
-        //ret = RCC_AHB1Periph_GPIOB;
-        ret = RCC_APB2Periph_GPIOB;
-    else if (_qual == GPIOC)
-        //ret = RCC_AHB1Periph_GPIOC;
-        ret = RCC_APB2Periph_GPIOC;
-    else if (_qual == GPIOD)
-        //ret = RCC_AHB1Periph_GPIOD;
-        ret = RCC_APB2Periph_GPIOD;
-    else if (_qual == GPIOE)
-        //ret = RCC_AHB1Periph_GPIOE;
-        ret = RCC_APB2Periph_GPIOE;
-    else if (_qual == GPIOF)
-        //ret = RCC_AHB1Periph_GPIOF;
-        ret = RCC_APB2Periph_GPIOA;
-#if defined(STM32F2XX) || defined(STM32F40XX) || defined(STM32F427X) || defined (STM32F429X)
-    else if (_qual == GPIOG)
-        ret = RCC_AHB1Periph_GPIOG;
-    else if (_qual == GPIOH)
-        ret = RCC_AHB1Periph_GPIOH;
-    else if (_qual == GPIOI)
-        ret = RCC_AHB1Periph_GPIOI;
-#endif	
-    return ret;
+    for (i = 0; i < STPDRV_MAXBANDS; i++) {
+        if ((Bands[mt][i].High == 0) || (_speed <= Bands[mt][i].Low) || (_speed >= Bands[mt][i].High))
+            continue;
+        if (((Bands[mt][i].High - _speed) < (_speed - Bands[mt][i].Low)) && (Bands[mt][i].High <= MAX_SPEED(mt)))
+            return Bands[mt][i].High;
+        return Bands[mt][i].Low;
+    }
+    return _speed;
 }
 //==============================================================================
+#endif
+
+#ifdef STPDRV_USE_ARC
+//==============================================================================
+//	descri:  Evento do canal 1 durante um arco. Alterna entre o flanco ascendente dos STEP decididos
+//				e o flanco descendente, onde é calculado o proximo movimento pelo algoritmo do midpoint
+//				(só inteiros): o eixo maior do octante avança sempre, o menor avança se isso diminuir o
+//				erro |X^2 + Y^2 - R^2|. Os DIR são mudados no flanco descendente, meio periodo antes do
+//				STEP seguinte. Os steps diagonais têm o periodo multiplicado por ~sqrt(2) (181/128)
+//				para manter a velocidade tangencial
+//	params:	nada
+//	return:	nada
+//
+static void __OnArcTimer(void)
+{
+    int64_t fm, fb;
+    int8_t sx, sy;
+    uint8_t oct;
+
+    if (Arc.Phase) {
+        if (Arc.StepX) {
+            STPHAL_PIN_SET(MOTOR1_STEP_PORT, MOTOR1_STEP_PIN);
+            Motors[0].Pos += Arc.SX;
+        }
+        if (Arc.StepY) {
+            STPHAL_PIN_SET(MOTOR2_STEP_PORT, MOTOR2_STEP_PIN);
+            Motors[1].Pos += Arc.SY;
+        }
+        STPHAL_CC_RELOAD(1, Arc.Delay);
+        Arc.Phase = 0;
+        return;
+    }
+
+    STPHAL_PIN_RESET(MOTOR1_STEP_PORT, MOTOR1_STEP_PIN);
+    STPHAL_PIN_RESET(MOTOR2_STEP_PORT, MOTOR2_STEP_PIN);
+
+    if (!Arc.Finish) {
+        oct = __ArcOctant(Arc.X, Arc.Y);
+        if (oct != Arc.Oct) {
+            Arc.Oct = oct;
+            if (Arc.Cross)
+                Arc.Cross--;
+        }
+        // no octante final o eixo maior passa exactamente pela coordenada final
+        if ((Arc.Cross == 0) && (ArcMajorY[oct] ? (Arc.Y == Arc.YE) : (Arc.X == Arc.XE)))
+            Arc.Finish = 1;
+        else if (Arc.Guard == 0)
+            Arc.Finish = 1;
+        else
+            Arc.Guard--;
+    }
+
+    if (Arc.Finish) {
+        // correcção final do eixo menor (o ponto final pode não estar exactamente no circulo)
+        if ((Arc.X == Arc.XE) && (Arc.Y == Arc.YE)) {
+            __ArcEnd();
+            return;
+        }
+        sx = (Arc.XE > Arc.X) ? 1 : -1;
+        sy = (Arc.YE > Arc.Y) ? 1 : -1;
+        Arc.StepX = (Arc.X != Arc.XE);
+        Arc.StepY = (Arc.Y != Arc.YE);
+    } else {
+        oct = Arc.Oct;
+        sx = ArcSX[oct] * Arc.Sign;
+        sy = ArcSY[oct] * Arc.Sign;
+        if (ArcMajorY[oct]) {
+            fm = Arc.F + 2 * (int64_t) Arc.Y * sy + 1;
+            fb = fm + 2 * (int64_t) Arc.X * sx + 1;
+            Arc.StepY = 1;
+            Arc.StepX = ((fb < 0 ? -fb : fb) < (fm < 0 ? -fm : fm));
+        } else {
+            fm = Arc.F + 2 * (int64_t) Arc.X * sx + 1;
+            fb = fm + 2 * (int64_t) Arc.Y * sy + 1;
+            Arc.StepX = 1;
+            Arc.StepY = ((fb < 0 ? -fb : fb) < (fm < 0 ? -fm : fm));
+        }
+        Arc.F = (Arc.StepX && Arc.StepY) ? fb : fm;
+    }
+
+    if (Arc.StepX) {
+        Arc.X += sx;
+        if (sx != Arc.SX) {
+            __MotorSetDir(0, sx > 0 ? dir_CW : dir_CCW);
+            Arc.SX = sx;
+        }
+    }
+    if (Arc.StepY) {
+        Arc.Y += sy;
+        if (sy != Arc.SY) {
+            __MotorSetDir(1, sy > 0 ? dir_CW : dir_CCW);
+            Arc.SY = sy;
+        }
+    }
+
+    // perfil tangencial: conta a distancia de aceleração e desacelera quando o que falta for igual
+    if (Arc.Rem)
+        Arc.Rem--;
+    if (!Arc.Decel) {
+        if (Motors[0].TargetCurSpeed < Motors[0].TargetSpeed)		// rampa a acelerar
+            Arc.AccelSteps++;
+        if (Arc.Rem <= Arc.AccelSteps) {
+            Arc.Decel = 1;
+            __SetTargetSpeed(0, STPDRV_STARTSTOPSEC, Motors[0].Dir, mstat_Arc);
+        }
+    }
+
+    Arc.Delay = (Arc.StepX && Arc.StepY) ? (stphal_tick_t) (((uint32_t) Motors[0].CurDelay * 181) >> 7) : Motors[0].CurDelay;
+    STPHAL_CC_RELOAD(1, Arc.Delay);
+    Arc.Phase = 1;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Velocidade de um eixo durante o arco, a tangencial vezes |Y|/R para o X e |X|/R para o Y
+//	params:	mt - motor
+//	return:	velocidade em steps/sec
+//
+static uint16_t __ArcSpeed(int16_t mt)
+{
+    int32_t c = (mt == (int16_t) 0x0) ? Arc.Y : Arc.X;
+
+    if (Motors[0].CurDelay == 0)
+        return 0;
+    c = c < 0 ? -c : c;
+    if (c > Arc.R)
+        c = Arc.R;		// o ponto pode estar até meio step fora do circulo
+    return (uint16_t) ((uint64_t) CUR_SPEED(0) * (uint32_t) c / (uint32_t) Arc.R);
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Termina o arco e pára os dois motores
+//	params:	nada
+//	return:	nada
+//
+static void __ArcEnd(void)
+{
+    Arc.Active = 0;
+    __ResetTargetSpeed(0);
+    __MotorOff(0);
+    Motors[0].State = mstat_Stop;
+    Motors[1].State = mstat_Stop;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Octante (0 a 7, no sentido CCW a partir do eixo +X) de um ponto relativo ao centro.
+//				Cada octante é meio aberto [a, b[ para que o percurso mude de octante de forma monotona
+//	params:	x, y - ponto
+//	return:	octante
+//
+static uint8_t __ArcOctant(int32_t x, int32_t y)
+{
+    if (y >= 0) {
+        if (x > 0)
+            return (x > y) ? 0 : 1;
+        return (-x < y) ? 2 : 3;
+    }
+    if (x < 0)
+        return (-x > -y) ? 4 : 5;
+    return (x < -y) ? 6 : 7;
+}
+//==============================================================================
+#endif
+
+#if defined(STPDRV_USE_ARC) || defined(STPDRV_USE_SHAPER)
+//==============================================================================
+//	descri:  Raiz quadrada inteira (arredondada para baixo)
+//	params:	v - valor
+//	return:	raiz
+//
+static uint32_t __ISqrt(uint64_t _v)
+{
+    uint64_t res = 0, bit = (uint64_t) 1 << 62;
+
+    while (bit > _v)
+        bit >>= 2;
+    while (bit) {
+        if (_v >= res + bit) {
+            _v -= res + bit;
+            res = (res >> 1) + bit;
+        } else
+            res >>= 1;
+        bit >>= 2;
+    }
+    return (uint32_t) res;
+}
+//==============================================================================
+#endif
+
+#ifdef STPDRV_USE_TRACE
+//==============================================================================
+//	descri:  Regista um evento no trace. Chamada nas IRQs e fora delas, a reserva da posição no
+//				buffer e a escrita são feitas com as IRQs desligadas (poucos ciclos)
+//	params:	ev - evento
+//          mt - motor
+//          data - valor associado ao evento (ver mtrace_t)
+//	return:	nada
+//
+static __INLINE void __Trace(mtrace_t _ev, int16_t mt, uint16_t _data)
+{
+    mtrace_rec_t *rec;
+    uint32_t primask;
+
+    if (!Trace.Enable)
+        return;
+    primask = __get_PRIMASK();
+    __disable_irq();
+    rec = &Trace.Buf[Trace.Idx++ & (STPDRV_TRACE_LEN - 1)];
+    rec->Time	= STPDRV_CYCCNT;
+    rec->Event	= (uint8_t) _ev;
+    rec->Motor	= (uint8_t) mt;
+    rec->Data	= _data;
+    __set_PRIMASK(primask);
+}
+//==============================================================================
+#endif
+
+#ifdef STPDRV_USE_RECORD
+//==============================================================================
+//	descri:  Começa a gravação no arranque do motor: DIR e meio periodo inicial
+//	params:	mt - motor
+//	return:	nada
+//
+static void __RecBegin(int16_t mt)
+{
+    Recs[mt].Len	= 0;
+    Recs[mt].Run	= 0;
+    Recs[mt].Last	= Motors[mt].CurDelay;
+    Recs[mt].Dir	= Motors[mt].Dir;
+    __RecByte(mt, (uint8_t) Motors[mt].Dir);
+    __RecByte(mt, (uint8_t) Motors[mt].CurDelay);
+    __RecByte(mt, (uint8_t) (Motors[mt].CurDelay >> 8));
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Grava um meio periodo. Chamada na IRQ do STEP depois do flanco, com o incremento do
+//				CCR já feito (inclui o STPDRV_DIRSETUP de uma inversão)
+//	params:	mt - motor
+//          delay - incremento do CCR neste evento
+//	return:	nada
+//
+static void __RecPut(int16_t mt, stphal_tick_t _delay)
+{
+    TRec *rc = &Recs[mt];
+    int32_t d;
+
+#if STPHAL_TICK_MAX > 0xFFFF
+    if (_delay > 0xFFFF) {
+        rc->Mode = REC_OVERFLOW;		// a gravação guarda meio periodos de 16 bits
+        return;
+    }
+#endif
+    if (Motors[mt].Dir != rc->Dir) {
+        __RecFlush(mt);
+        __RecByte(mt, REC_FLIP);
+        rc->Dir = Motors[mt].Dir;
+    }
+    if ((_delay == rc->Last) && (rc->Run < 0xFFFF)) {
+        rc->Run++;
+        return;
+    }
+    __RecFlush(mt);
+    d = (int32_t) _delay - rc->Last;
+    if (d == 0)
+        rc->Run = 1;			// Run estava cheio
+    else if ((d >= -64) && (d <= 63))
+        __RecByte(mt, (uint8_t) (d & 0x7F));
+    else {
+        __RecByte(mt, REC_ABS);
+        __RecByte(mt, (uint8_t) _delay);
+        __RecByte(mt, (uint8_t) (_delay >> 8));
+    }
+    rc->Last = _delay;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Grava os meio periodos iguais pendentes
+//	params:	mt - motor
+//	return:	nada
+//
+static void __RecFlush(int16_t mt)
+{
+    TRec *rc = &Recs[mt];
+
+    if (rc->Run == 0)
+        return;
+    if (rc->Run <= 64)
+        __RecByte(mt, (uint8_t) (REC_RUN | (rc->Run - 1)));
+    else {
+        __RecByte(mt, REC_LRUN);
+        __RecByte(mt, (uint8_t) rc->Run);
+        __RecByte(mt, (uint8_t) (rc->Run >> 8));
+    }
+    rc->Run = 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Escreve um byte na gravação, se o buffer encher a gravação é abandonada
+//	params:	mt - motor
+//          b - byte
+//	return:	nada
+//
+static void __RecByte(int16_t mt, uint8_t _b)
+{
+    if (Recs[mt].Mode != REC_RECORD)
+        return;
+    if (Recs[mt].Len >= Recs[mt].Size) {
+        Recs[mt].Mode = REC_OVERFLOW;
+        return;
+    }
+    Recs[mt].Buf[Recs[mt].Len++] = _b;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Lê o proximo meio periodo da gravação para CurDelay, antes do flanco. No ultimo
+//				meio periodo o motor é desligado, o flanco deste evento é ainda dado pela IRQ
+//	params:	mt - motor
+//	return:	nada
+//
+static void __PlayNext(int16_t mt)
+{
+    TRec *rc = &Recs[mt];
+    uint16_t v;
+    uint8_t b;
+
+    if (rc->Run)
+        rc->Run--;
+    else {
+        for (;;) {
+            b = rc->Buf[rc->Len++];
+            if (b < REC_RUN) {
+                rc->Last += (uint16_t) ((int8_t) (b << 1) >> 1);		// delta de 7 bits com sinal
+                break;
+            }
+            if (b < REC_ABS) {
+                rc->Run = b & 0x3F;
+                break;
+            }
+            if (b == REC_FLIP) {
+                Motors[mt].DirPending = 1;		// ver __DirPendingFlip
+                continue;
+            }
+            v = (uint16_t) (rc->Buf[rc->Len] | (rc->Buf[rc->Len + 1] << 8));
+            rc->Len += 2;
+            if (b == REC_ABS)
+                rc->Last = v;
+            else
+                rc->Run = v - 1;
+            break;
+        }
+    }
+    Motors[mt].CurDelay = rc->Last;
+    if ((rc->Run == 0) && (rc->Buf[rc->Len] == REC_END)) {
+        __MotorOff(mt);
+        Motors[mt].State = mstat_Stop;
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Põe o pino STEP a LOW (motor parado), a gravação e a reprodução começam com um flanco
+//				ascendente
+//	params:	mt - motor
+//	return:	nada
+//
+static void __StepLow(int16_t mt)
+{
+    if (mt == (int16_t) 0x0)
+        STPHAL_PIN_RESET(MOTOR1_STEP_PORT, MOTOR1_STEP_PIN);
+    else
+        STPHAL_PIN_RESET(MOTOR2_STEP_PORT, MOTOR2_STEP_PIN);
+}
+//==============================================================================
+#endif
 
 //==============================================================================
 //
 static void __OnRampTimer(int16_t mt)
 {
     if (Motors[mt].TargetSpeed > Motors[mt].TargetCurSpeed) {
-        // Acell fase
-        Motors[mt].TargetCurSpeed += Motors[mt].RampSlop;
-        if (Motors[mt].TargetCurSpeed > Motors[mt].TargetSpeed)
+        // Acell fase, compara antes de somar (com um CurSlop grande a soma dava a volta)
+        if (Motors[mt].TargetSpeed - Motors[mt].TargetCurSpeed <= Motors[mt].CurSlop)
             Motors[mt].TargetCurSpeed = Motors[mt].TargetSpeed;
-        Motors[mt].CurDelay = STPDRV_TIMFREQ / Motors[mt].TargetCurSpeed;
+        else
+            Motors[mt].TargetCurSpeed += Motors[mt].CurSlop;
+        if (Motors[mt].TargetCurSpeed > MAX_SPEED(mt))
+            Motors[mt].TargetCurSpeed = MAX_SPEED(mt);
+        __UpdateDelay(mt);
     } else if (Motors[mt].TargetSpeed < Motors[mt].TargetCurSpeed) {
-        // Decel fase
-        Motors[mt].TargetCurSpeed -= Motors[mt].RampSlop;
-        if (Motors[mt].TargetCurSpeed < Motors[mt].TargetSpeed)
+        // Decel fase, compara antes de subtrair
+        if (Motors[mt].TargetCurSpeed - Motors[mt].TargetSpeed <= Motors[mt].CurSlop)
             Motors[mt].TargetCurSpeed = Motors[mt].TargetSpeed;
-        Motors[mt].CurDelay = STPDRV_TIMFREQ / Motors[mt].TargetCurSpeed;
+        else
+            Motors[mt].TargetCurSpeed -= Motors[mt].CurSlop;
+        __UpdateDelay(mt);
+    } else if ((Motors[mt].PlanIdx < Motors[mt].PlanLen) && Motors[mt].Plan[Motors[mt].PlanIdx].Speed) {
+        // segmento atingido, passa ao seguinte do plano sem parar a rampa
+        __PlanNext(mt);
+#ifdef STPDRV_USE_SHAPER
+    } else if (Shapers[mt].Settle) {
+        // velocidade comandada atingida mas a saída do shaper ainda não estabilizou
+        Shapers[mt].Settle--;
+        Motors[mt].CurDelay = SPEED2DELAY(mt, __ShaperApply(mt, Motors[mt].TargetCurSpeed));
+#endif
     } else
         __TargetSpeedDone(mt);
 }
 //==============================================================================
 
+//==============================================================================
+//	descri:  Actualiza o CurDelay a partir da velocidade comandada (TargetCurSpeed), passando
+//				pelo shaper se estiver activo
+//	params:	mt - motor
+//	return:	nada
+//
+static void __UpdateDelay(int16_t mt)
+{
+#ifdef STPDRV_USE_MICROSTEP
+    __MsSelect(mt, Motors[mt].TargetCurSpeed);
+#endif
+#ifdef STPDRV_USE_SHAPER
+    if (Shapers[mt].Type != shaper_None) {
+        Shapers[mt].Settle = Shapers[mt].SettleTicks;
+        Motors[mt].CurDelay = SPEED2DELAY(mt, __ShaperApply(mt, Motors[mt].TargetCurSpeed));
+        return;
+    }
+#endif
+    Motors[mt].CurDelay = SPEED2DELAY(mt, Motors[mt].TargetCurSpeed);
+}
+//==============================================================================
+
+#ifdef STPDRV_USE_SHAPER
+//==============================================================================
+//	descri:  Calcula as amplitudes (Q15) e os atrasos dos impulsos do shaper a partir da frequência,
+//				do amortecimento e do periodo da rampa (RampDelay). Só aritmética inteira (o M3 não
+//				tem FPU), K vem da tabela ShaperK e sqrt(1 - z^2) de __ISqrt
+//				  K  = exp(-z.pi / sqrt(1 - z^2)),  meio periodo amortecido = 1 / (2.f.sqrt(1 - z^2))
+//				  ZV  = [1, K] / (1 + K)            em t = [0, T/2]
+//				  ZVD = [1, 2K, K^2] / (1 + K)^2    em t = [0, T/2, T]
+//	params:	mt - motor
+//	return:	nada, se os atrasos não couberem no historico o shaper é desligado
+//
+static void __ShaperCalc(int16_t mt)
+{
+    TShaper *sh = &Shapers[mt];
+    uint32_t z, k, wd, r, n, div;
+
+    sh->Settle = 0;
+    if (sh->Type == shaper_None)
+        return;
+
+    z 	= ((uint32_t) sh->Damping << 15) / 1000;								// amortecimento em Q15
+    k 	= (ShaperK[z >> 10] * (1024 - (z & 1023)) + ShaperK[(z >> 10) + 1] * (z & 1023)) >> 10;
+    wd 	= __ISqrt(1000000 - (uint32_t) sh->Damping * sh->Damping);				// sqrt(1 - z^2) em milésimos
+    if (wd == 0)
+        wd = 1;
+    // meio periodo em ticks da rampa = 10 / (2.Freq.wd) * (2.TIMFREQ / RampDelay), Freq em dHz
+    n = ((uint32_t) STPDRV_TIMFREQ * 10000 + Motors[mt].RampDelay / 2) / Motors[mt].RampDelay;
+    n = (n + (sh->Freq * wd) / 2) / (sh->Freq * wd);
+
+    if (n == 0)
+        n = 1;
+    // decimação do historico para o ultimo impulso caber em STPDRV_SHAPER_LEN amostras
+    div = ((sh->Type == shaper_ZVD ? 2 * n : n) + STPDRV_SHAPER_LEN - 2) / (STPDRV_SHAPER_LEN - 1);
+    if (div == 0)
+        div = 1;
+    if (div > 0xffff) {
+        sh->Type = shaper_None;
+        return;
+    }
+    n = (n + div / 2) / div;
+    if (n == 0)
+        n = 1;
+    while ((sh->Type == shaper_ZVD ? 2 * n : n) >= STPDRV_SHAPER_LEN)
+        n--;		// o arredondamento não pode passar o fim do historico
+
+    // r = K / (1 + K) em Q15, 1 / (1 + K) = 1 - r
+    r = ((k << 15) + (32768 + k) / 2) / (32768 + k);
+    sh->N[0] = 0;
+    sh->N[1] = (uint16_t) n;
+    if (sh->Type == shaper_ZV) {
+        sh->N[2] = 0;
+        sh->A[1] = (uint16_t) r;
+        sh->A[2] = 0;
+    } else {
+        sh->N[2] = (uint16_t) (2 * n);
+        sh->A[1] = (uint16_t) ((2 * r * (32768 - r) + 16384) >> 15);
+        sh->A[2] = (uint16_t) ((r * r + 16384) >> 15);
+    }
+    sh->A[0] = (uint16_t) (32768 - sh->A[1] - sh->A[2]);
+    sh->Div = (uint16_t) div;
+    n = (sh->N[sh->Type == shaper_ZV ? 1 : 2] + 1) * div;
+    sh->SettleTicks = (uint16_t) (n > 0xffff ? 0xffff : n);
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Enche o historico do shaper com a velocidade actual (motor em regime estável)
+//	params:	mt - motor
+//          speed - velocidade actual em steps/sec
+//	return:	nada
+//
+static void __ShaperReset(int16_t mt, uint16_t _speed)
+{
+    uint16_t i;
+
+    for (i = 0; i < STPDRV_SHAPER_LEN; i++)
+        Shapers[mt].Hist[i] = _speed;
+    Shapers[mt].Idx = 0;
+    Shapers[mt].DivCnt = 0;
+    Shapers[mt].Settle = 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Junta a velocidade comandada ao historico e devolve a velocidade convolvida com os
+//				impulsos do shaper. Só aritmética inteira, chamada na IRQ da rampa
+//	params:	mt - motor
+//          speed - velocidade comandada em steps/sec
+//	return:	velocidade a aplicar em steps/sec
+//
+static uint16_t __ShaperApply(int16_t mt, uint16_t _speed)
+{
+    TShaper *sh = &Shapers[mt];
+    uint32_t acc;
+
+    if (++sh->DivCnt >= sh->Div) {
+        sh->DivCnt = 0;
+        sh->Idx = (sh->Idx + 1) & (STPDRV_SHAPER_LEN - 1);
+    }
+    sh->Hist[sh->Idx] = _speed;
+
+    acc  = (uint32_t) sh->A[0] * _speed;
+    acc += (uint32_t) sh->A[1] * sh->Hist[(sh->Idx - sh->N[1]) & (STPDRV_SHAPER_LEN - 1)];
+    acc += (uint32_t) sh->A[2] * sh->Hist[(sh->Idx - sh->N[2]) & (STPDRV_SHAPER_LEN - 1)];
+    return (uint16_t) ((acc + 16384) >> 15);
+}
+//==============================================================================
+#endif
+
+#ifdef STPDRV_USE_ENCODER
+//==============================================================================
+//	descri:  Abre a janela de um STEP extra, chamada na IRQ do STEP no flanco ascendente de um
+//				STEP normal quando há correcção pendente. Os 4 meios periodos seguintes têm meio
+//				CurDelay: o primeiro flanco ascendente é o STEP extra (não conta em Pos) e o segundo
+//				é o STEP normal seguinte, que sai meio periodo atrasado mas a janela acaba no mesmo
+//				instante que acabaria sem o STEP extra. Não há STEPs extra acima de metade da
+//				velocidade maxima, numa inversão pendente, nem a gravar ou a reproduzir
+//	params:	mt - motor
+//	return:	nada
+//
+static void __InjectStart(int16_t mt)
+{
+    if ((Motors[mt].CurDelay < 2 * (STPDRV_TIMFREQ / STPDRV_MAXSETPSEC)) || Motors[mt].DirPending)
+        return;
+#ifdef STPDRV_USE_RECORD
+    if ((Recs[mt].Mode == REC_RECORD) || (Recs[mt].Mode == REC_PLAY))
+        return;
+#endif
+    Motors[mt].InjHalf = 4;
+}
+//==============================================================================
+#endif
+
+#ifdef STPDRV_USE_MICROSTEP
+//==============================================================================
+//	descri:  Escolhe a resolução para a velocidade comandada, um nivel de cada vez. Os niveis têm
+//				histerese (Up > Down), o nivel pedido fica em MsNext até ao proximo full step. Os arcos
+//				e as gravações ficam sempre na resolução em que começaram (a mais fina)
+//	params:	mt - motor
+//          speed - velocidade comandada em steps/sec
+//	return:	nada
+//
+static void __MsSelect(int16_t mt, uint16_t _speed)
+{
+    uint8_t l = Motors[mt].MsLevel;
+
+#ifdef STPDRV_USE_ARC
+    if (Arc.Active)
+        return;
+#endif
+#ifdef STPDRV_USE_RECORD
+    if ((Recs[mt].Mode == REC_RECORD) || (Recs[mt].Mode == REC_PLAY))
+        return;
+#endif
+    if ((l + 1 < STPDRV_MS_LEVELS) && Micros[mt][l + 1].Mul && (_speed >= Micros[mt][l + 1].Up))
+        l++;
+    else if ((l > 0) && (_speed < Micros[mt][l].Down))
+        l--;
+    Motors[mt].MsNext = l;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Muda para a resolução pedida (MsNext) se o indexador do IC estiver num full step.
+//				É chamada na IRQ do STEP logo após o flanco descendente, os pinos MSx mudam meio
+//				periodo antes do proximo STEP. O compare desse meio periodo já foi carregado com
+//				o CurDelay antigo e é corrigido pela diferença
+//	params:	mt - motor
+//	return:	nada
+//
+static void __MsSwitch(int16_t mt)
+{
+    stphal_tick_t d;
+
+    if ((uint32_t) (Motors[mt].Pos - Motors[mt].MsOrg) & (STPDRV_MS_FULL - 1))
+        return;
+#ifdef STPDRV_USE_ENCODER
+    if (Motors[mt].InjHalf)
+        return;		// a meio da janela do STEP extra o compare tem meio CurDelay
+#endif
+    d = Motors[mt].CurDelay;
+    __MsApply(mt, Motors[mt].MsNext);
+    d = (stphal_tick_t) (Motors[mt].CurDelay - d);
+    if (mt == (int16_t) 0x0)
+        STPHAL_CC_RELOAD(1, d);
+    else
+        STPHAL_CC_RELOAD(2, d);
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Escreve os pinos MSx de um nivel e converte o CurDelay para a nova resolução, a
+//				velocidade em steps/sec e a rampa não mudam. A correcção pendente do encoder era em
+//				STEPs da resolução antiga e é anulada
+//	params:	mt - motor
+//          level - nivel em Micros
+//	return:	nada
+//
+static void __MsApply(int16_t mt, uint8_t _level)
+{
+    uint32_t d = (uint32_t) Motors[mt].CurDelay * Micros[mt][_level].Mul / Motors[mt].MsMul;
+    uint16_t pins = Micros[mt][_level].Pins;
+
+    if (mt == (int16_t) 0x0)
+        STPHAL_PIN_WRITE(MOTOR1_MS_PORT, MOTOR1_MS_PINS, pins);
+    else
+        STPHAL_PIN_WRITE(MOTOR2_MS_PORT, MOTOR2_MS_PINS, pins);
+    Motors[mt].CurDelay	= d ? STPHAL_TICKS(d) : 1;
+    Motors[mt].MsMul	= Micros[mt][_level].Mul;
+    Motors[mt].MsLevel	= _level;
+    Motors[mt].MsNext	= _level;
+#ifdef STPDRV_USE_ENCODER
+    Motors[mt].Inject	= 0;
+    Motors[mt].InjHalf	= 0;
+#endif
+    TRACE(trc_Micro, mt, Motors[mt].MsMul);
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Calcula a velocidade maxima com o ultimo nivel configurado (STPDRV_MAXSETPSEC STEPs por
+//				segundo nessa resolução), no maximo 32767 que é o limite do "speed" da API
+//	params:	mt - motor
+//	return:	nada
+//
+static void __MsLimit(int16_t mt)
+{
+    uint32_t max = STPDRV_MAXSETPSEC;
+    int16_t l;
+
+    for (l = 1; (l < STPDRV_MS_LEVELS) && Micros[mt][l].Mul; l++)
+        max = (uint32_t) STPDRV_MAXSETPSEC * Micros[mt][l].Mul;
+    Motors[mt].MsMax = max > 0x7FFF ? 0x7FFF : (uint16_t) max;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Velocidade actual em steps/sec a partir do CurDelay. A IRQ do STEP pode mudar a
+//				resolução entre a leitura do MsMul e a do CurDelay, nesse caso lê outra vez
+//	params:	mt - motor
+//	return:	steps/sec
+//
+static uint32_t __MsSpeed(int16_t mt)
+{
+    stphal_tick_t d;
+    uint16_t mul;
+
+    do {
+        mul = Motors[mt].MsMul;
+        d = *(__IO stphal_tick_t *) &Motors[mt].CurDelay;
+    } while (mul != Motors[mt].MsMul);
+    return ((uint32_t) STPDRV_TIMFREQ * mul) / d;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Meio periodo em ticks para uma velocidade na resolução actual
+//	params:	mt - motor
+//          speed - velocidade em steps/sec
+//	return:	CurDelay, no maximo STPHAL_TICK_MAX
+//
+static stphal_tick_t __MsDelay(int16_t mt, uint16_t _speed)
+{
+    uint32_t d = ((uint32_t) STPDRV_TIMFREQ * Motors[mt].MsMul) / _speed;
+
+    return STPHAL_TICKS(d);
+}
+//==============================================================================
+#endif
+
 //=============================================================================
 // EOF stm32f_stpdrv.c
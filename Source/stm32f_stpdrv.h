@@ -32,7 +32,26 @@
 	-  Velocidade constante (Move) ou posicionamento (Goto) independente e simultânea para os dois motores
 	- 	Contador com a posição actual do motor (respeita a direcção dos movimentos)
 	- 	Direcção CW (clockwise) ou CCW (counterclockwise )
+	- 	Inversão de direcção rápida: desacelera até STPDRV_STARTSTOPSEC, inverte o DIR sincronizado
+		com o STEP (respeitando STPDRV_DIRSETUP) e volta a acelerar de imediato
+	- 	Input shaping opcional (ZV/ZVD) para suprimir a ressonância da estrutura (STPDRV_USE_SHAPER)
+	- 	Bandas de velocidade proibidas (ressonância "mid-band") por motor, atravessadas com aceleração
+		maior (STPDRV_USE_BANDS)
+	- 	Arcos de circunferência coordenados MOTOR1 (X) / MOTOR2 (Y) sem vírgula flutuante (STPDRV_USE_ARC)
+	- 	Trace opcional dos eventos do driver com timestamp num buffer circular, para analisar
+		movimentos depois de uma falha (STPDRV_USE_TRACE, ver Tools/stptrace.c)
+	- 	Verificação da posição por encoder em quadratura com detecção de stall e correcção dos
+		passos perdidos (STPDRV_USE_ENCODER, ver stm32f_stpenc.h)
+	- 	Homing e fins de curso por EXTI com a posição capturada no flanco do interruptor
+		(STPDRV_USE_HOMING, ver stm32f_stphome.h)
+	- 	Gravação de um movimento (os meio periodos do STEP e as inversões do DIR) num buffer
+		comprimido e reprodução exacta sem cálculo da rampa (STPDRV_USE_RECORD)
+	- 	Mudança automática da resolução do microstepping pelos pinos MSx do IC a velocidades
+		configuráveis, num full step, para velocidades acima de STPDRV_MAXSETPSEC impulsos por
+		segundo (STPDRV_USE_MICROSTEP)
 	- 	Usa somente um TIMER (TIMER3, pode ser alterado) 
+	- 	Acesso ao timer e aos GPIO pelo stm32f_stphal.h, com backends para o STM32F1, para o
+		STM32F2/F4 (TIM2/TIM5 de 32 bits) e para o PC (Tools/host)
 	- 	Permite assignar qualquer pino IO para DIR e STEP
 	- 	E mais umas cenas ...
 
@@ -70,6 +89,38 @@
 			Return:  um int32 com o valor da posição
 
 
+	void STPDRV_SetPos(int16_t motor, int32_t position)
+			Descri: 	Para mudar a posição (contador de passos) actual, por exemplo depois do homing
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+						position - nova posição
+			Return:  none
+
+
+	uint16_t STPDRV_GetSpeed(int16_t motor)
+			Descri: 	Para obter a velocidade actual do motor (a da rampa, não a pedida). Durante um
+						arco é a velocidade de cada eixo: a tangencial vezes |Y|/R para o MOTOR1 e |X|/R
+						para o MOTOR2
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+			Return:  velocidade em steps/sec, ZERO se o motor estiver parado
+
+
+	uint16_t STPDRV_GetMaxSpeed(int16_t motor)
+			Descri: 	Para obter a maior velocidade aceite por STPDRV_Move(...) (STPDRV_MAXSETPSEC, ou
+						com STPDRV_USE_MICROSTEP a do ultimo nivel configurado)
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+			Return:  velocidade em steps/sec
+
+
+	void STPDRV_GetStatus(int16_t motor, mstatus_t *status)
+			Descri: 	Para obter de uma só vez o estado interno do motor (posição, velocidade da rampa,
+						CurDelay, estado e direcção). Para um valor coerente deve ser chamada com a
+						IRQ do driver impedida de interromper (mesma prioridade ou IRQs desligadas)
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+						status - estrutura a preencher, RampSpeed é ZERO quando a rampa está parada.
+						Durante um arco RampSpeed e CurDelay são os de cada eixo (ver STPDRV_GetSpeed)
+			Return:  none
+
+
 	int32_t STPDRV_GetDir(int16_t motor)
 			Descri: 	Para obter a direcção de movimento actual ou a ultima usada se o motor
 						estiver parado
@@ -83,6 +134,7 @@
 			Return:  mstat_Stop = motor está parado, mstat_Move = motor está em movimento
 						mstat_GoTo  = motor está em movimento para uma determinada posição em
 						consequência de um comando "STPDRV_Goto(...)"
+						mstat_Arc   = motor está a executar um arco "STPDRV_Arc(...)" (os dois motores)
 
 
 	void STPDRV_Move(int16_t motor, mdir_t direction, int16_t speed)
@@ -110,14 +162,155 @@
 			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
 						hardstop - se "1" pára o motor imediatamente, se "0" pára o motor com desaceleração
 			Return: none
+
+
+	int16_t STPDRV_SetShaper(int16_t motor, mshaper_t type, uint16_t freq, uint16_t damping)
+			Descri: 	Define o input shaper aplicado à velocidade comandada pela rampa (só com
+						STPDRV_USE_SHAPER). A velocidade é convolvida com uma sequência de impulsos
+						ZV ou ZVD calculada para a frequência de ressonância e amortecimento indicados,
+						o que permite usar acelerações maiores sem vibração. Deve ser chamada de novo
+						sempre que a frequência mude, STPDRV_SetRamp(...) recalcula o shaper
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+						type - shaper_None (desliga), shaper_ZV ou shaper_ZVD
+						freq - frequência de ressonância em décimas de Hz (ex: 255 = 25.5Hz)
+						damping - factor de amortecimento em milésimos (ex: 50 = 0.05), menor que 1000
+			Return:  1 se OK, 0 se os parâmetros forem inválidos (o shaper fica desligado)
+
+
+	int16_t STPDRV_SetBand(int16_t motor, int16_t band, uint16_t low, uint16_t high, uint16_t slopmul)
+			Descri: 	Define uma banda de velocidades proibida (só com STPDRV_USE_BANDS). Uma velocidade
+						de cruzeiro dentro da banda é mudada para o limite mais proximo e as rampas que
+						a atravessam usam uma aceleração slopmul vezes maior dentro da banda. Tudo é
+						calculado quando o movimento é planeado, não nas IRQs. As bandas devem estar
+						por ordem crescente de band e não se podem sobrepor
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+						band - indice da banda, 0 a STPDRV_MAXBANDS - 1
+						low, high - limites da banda em steps/sec, high = 0 apaga a banda
+						slopmul - multiplicador da aceleração dentro da banda, o slope da rampa vezes
+						slopmul não pode passar de low (chamar depois de STPDRV_SetRamp)
+						A banda não pode conter STPDRV_STARTSTOPSEC (só como limite), a inversão de
+						sentido e a paragem com desaceleração têm um segmento a essa velocidade
+			Return:  1 se OK, 0 se os parâmetros forem inválidos
+
+
+	int16_t STPDRV_Arc(int32_t cx, int32_t cy, int32_t ex, int32_t ey, mdir_t dir, int16_t speed)
+			Descri: 	Executa um arco de circunferência com o MOTOR1 como eixo X e o MOTOR2 como eixo Y
+						(só com STPDRV_USE_ARC). O arco parte da posição actual, o raio é a distância ao
+						centro, os steps são gerados aos pares por um algoritmo de midpoint inteiro num só
+						canal do timer, com rampa na velocidade tangencial (a do MOTOR1). Se o ponto final
+						for igual ao inicial é feita uma volta completa. Os dois motores devem estar parados
+			 Parms: 	cx, cy - centro do arco (posição absoluta em steps)
+						ex, ey - ponto final do arco (posição absoluta em steps)
+						dir - dir_CCW (anti-horário) ou dir_CW (horário) no plano X/Y, com X e Y
+						positivos no sentido dir_CW de cada motor
+						speed - velocidade tangencial em steps/sec
+			Return:  1 se o arco foi aceite, 0 se não (motores em movimento ou parâmetros inválidos)
+
+
+	void STPDRV_Inject(int16_t motor, uint16_t steps)
+			Descri: 	Passos de correcção a emitir (só com STPDRV_USE_ENCODER). São STEPs extra no
+						sentido actual, um em cada periodo do STEP (nesse periodo saem dois STEPs), que
+						recuperam passos perdidos: a posição já contou os passos perdidos e não conta os
+						STEPs extra, o motor volta a coincidir com a posição. Os STEPs normais e a
+						velocidade comandada não mudam. Não há STEPs extra acima de metade de
+						STPDRV_MAXSETPSEC nem a gravar ou a reproduzir (ficam pendentes). Substitui a
+						correcção pendente, que é anulada quando o motor pára ou inverte a direcção.
+						Normalmente chamada pelo stm32f_stpenc
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+						steps - passos em atraso
+			Return:  none
+
+
+	int16_t STPDRV_SetMicrostep(int16_t motor, int16_t level, uint16_t mul, uint16_t pins, uint16_t up, uint16_t down)
+			Descri: 	Define uma resolução do microstepping (só com STPDRV_USE_MICROSTEP). As posições e as
+						velocidades da API são sempre em microsteps da resolução mais fina (nivel 0), nas
+						resoluções grossas cada impulso do STEP vale "mul" microsteps. A rampa passa ao
+						nivel seguinte quando a velocidade chega a "up" e volta ao anterior abaixo de
+						"down", a mudança dos pinos é feita no flanco descendente do STEP quando a posição
+						do indexador do IC está num full step (multiplo de STPDRV_MS_FULL). A velocidade
+						maxima passa a STPDRV_MAXSETPSEC * mul do ultimo nivel. As gravações e os arcos
+						são sempre na resolução mais fina. O indexador do IC tem de estar num full step
+						no STPDRV_Init() (como depois do reset do IC)
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+						level - 0 a STPDRV_MS_LEVELS - 1, 0 é a resolução mais fina (mul, up e down
+								  ignorados), os outros por ordem crescente de mul
+						mul - microsteps do nivel 0 por impulso, divisor de STPDRV_MS_FULL. ZERO apaga
+								o nivel e os seguintes deixam de ser usados
+						pins - pinos MSx a HIGH neste nivel (de MOTORx_MS_PINS, os outros ficam a LOW)
+						up - velocidade em steps/sec a partir da qual se usa este nivel, no maximo
+							  STPDRV_MAXSETPSEC * mul do nivel anterior (com margem para o full step)
+						down - velocidade abaixo da qual se volta ao nivel anterior, menor que up
+			Return:  1 se OK, 0 se os parametros forem inválidos ou o motor não estiver parado no nivel 0
+
+
+	int16_t STPDRV_RecStart(int16_t motor, uint8_t *buf, uint16_t size)
+			Descri: 	Prepara a gravação de um movimento (só com STPDRV_USE_RECORD). A gravação começa
+						quando o motor arrancar e acaba quando parar, cada meio periodo do STEP é guardado
+						em delta/run-length (1 byte por mudança pequena da rampa, 1 byte por até 64
+						meio periodos iguais, 3 bytes por até 65535). Os arcos não são gravados
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+						buf - buffer em RAM
+						size - tamanho do buffer em bytes
+			Return:  1 se OK, 0 se o motor estiver em movimento
+
+
+	uint16_t STPDRV_RecEnd(int16_t motor)
+			Descri: 	Termina a gravação (só com STPDRV_USE_RECORD). Os bytes gravados podem ser
+						reproduzidos do buffer ou copiados para uma página de flash
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+			Return:  tamanho da gravação em bytes, ZERO se o motor ainda estiver a andar (a gravação
+						continua), se não houver nada gravado ou se o buffer encheu
+
+
+	int16_t STPDRV_Replay(int16_t motor, const uint8_t *buf, uint16_t len)
+			Descri: 	Reproduz uma gravação (só com STPDRV_USE_RECORD). Os meio periodos e as inversões
+						são os gravados, a rampa não corre e o timing do STEP é igual ao da gravação em
+						todas as reproduções. Um STPDRV_Move(...) ou STPDRV_Stop(...) termina a reprodução
+						e continua a partir da velocidade actual. GetState dá mstat_Move até ao fim
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+						buf - gravação (RAM ou flash)
+						len - tamanho da gravação em bytes
+			Return:  1 se começou, 0 se o motor estiver em movimento ou a gravação for inválida
+
+
+	void STPDRV_TraceEnable(int16_t enable)
+			Descri: 	Liga ou suspende o registo de eventos no trace (só com STPDRV_USE_TRACE). O trace
+						arranca ligado em STPDRV_Init(), suspender depois de uma falha preserva os eventos
+						que a antecederam. Cada evento custa uma escrita de 8 bytes no buffer circular
+			 Parms: 	enable - 1 liga, 0 suspende
+			Return:  none
+
+
+	uint16_t STPDRV_TraceDump(mtrace_rec_t *dst, uint16_t first, uint16_t max)
+			Descri: 	Copia eventos do trace, do mais antigo para o mais recente (só com STPDRV_USE_TRACE).
+						Para uma cópia coerente em várias chamadas o trace deve estar suspenso
+			 Parms: 	dst - destino
+						first - indice do primeiro evento a copiar (0 = o mais antigo)
+						max - numero maximo de eventos a copiar
+			Return:  numero de eventos copiados
+
+
+	uint16_t STPDRV_TraceCount(void)
+			Descri: 	Para saber quantos eventos estão no trace (só com STPDRV_USE_TRACE)
+			 Parms: 	none
+			Return:  numero de eventos, no maximo STPDRV_TRACE_LEN
+
+
+	void STPDRV_TraceClear(void)
+			Descri: 	Apaga o trace (só com STPDRV_USE_TRACE)
+			 Parms: 	none
+			Return:  none
 	
 	
 ==============================================================================*/
 #ifndef  __stm32f_stpdrv_h    // DO NOT CHANGE
 #define  __stm32f_stpdrv_h    // DO NOT CHANGE
 
-// USER EDIT - Edit the line below to reflect your hardware
+// USER EDIT - Edit the lines below to reflect your hardware, o backend do stm32f_stphal.h sai daqui
 //#include "stm32f4xx.h"
+//#include "stm32f4xx_rcc.h"
+//#include "stm32f4xx_gpio.h"
+//#include "stm32f4xx_tim.h"
 //#include "stm32f3xx.h"
 //#include "stm32f2xx.h"
 #include <stm32f10x.h>
@@ -149,6 +342,26 @@
 #define IRQ_STPDRV_Priority      0x00
 
 
+// USER EDIT - Optional features, uncomment the lines below to enable
+//#define STPDRV_USE_SHAPER					// Input shaping (ZV/ZVD) da velocidade, ver STPDRV_SetShaper(...)
+//#define STPDRV_USE_BANDS					// Bandas de ressonância proibidas, ver STPDRV_SetBand(...)
+//#define STPDRV_USE_ARC						// Interpolação circular MOTOR1/MOTOR2, ver STPDRV_Arc(...)
+//#define STPDRV_USE_TRACE					// Trace dos eventos do driver, ver STPDRV_TraceDump(...)
+//#define STPDRV_USE_ENCODER				// Encoder em quadratura, ver stm32f_stpenc.h e STPDRV_Inject(...)
+//#define STPDRV_USE_HOMING					// Homing e fins de curso por EXTI, ver stm32f_stphome.h
+//#define STPDRV_USE_RECORD					// Gravação e reprodução de movimentos, ver STPDRV_Replay(...)
+//#define STPDRV_USE_MICROSTEP				// Resolução do microstepping automática, ver STPDRV_SetMicrostep(...)
+#define STPDRV_TRACE_LEN		64				// eventos no buffer do trace (8 bytes cada), potência de 2
+
+// USER EDIT - Pinos MSx do IC (só com STPDRV_USE_MICROSTEP), os de cada motor no mesmo port
+#define MOTOR1_MS_PORT			GPIOD
+#define MOTOR1_MS_PINS			(GPIO_Pin_0 | GPIO_Pin_1 | GPIO_Pin_2)		// todos os pinos MSx do IC
+#define MOTOR1_MS_FINE			(GPIO_Pin_0 | GPIO_Pin_1 | GPIO_Pin_2)		// a HIGH na resolução mais fina (A4988: 1/16)
+#define MOTOR2_MS_PORT			GPIOD
+#define MOTOR2_MS_PINS			(GPIO_Pin_3 | GPIO_Pin_4 | GPIO_Pin_5)
+#define MOTOR2_MS_FINE			(GPIO_Pin_3 | GPIO_Pin_4 | GPIO_Pin_5)
+
+
 
 /* ===========================================================================*/
 /* STOP ! - Private structs and vars - DO NOT CHANGE FROM THIS POINT ON 		*/
@@ -156,17 +369,48 @@
 
 //---- API enums
 typedef enum 	{dir_CW = (int8_t) 0, dir_CCW = (int8_t) 1, dir_ANY = (int8_t) 2}  mdir_t;
-typedef enum 	{mstat_Stop  = (int8_t) 0, mstat_Move  = (int8_t) 1, mstat_GoTo  = (int8_t) 2} mstate_t;
+typedef enum 	{mstat_Stop  = (int8_t) 0, mstat_Move  = (int8_t) 1, mstat_GoTo  = (int8_t) 2, mstat_Arc = (int8_t) 3} mstate_t;
+typedef enum 	{shaper_None = (int8_t) 0, shaper_ZV   = (int8_t) 1, shaper_ZVD  = (int8_t) 2} mshaper_t;
+typedef struct {
+    int32_t		Pos;				// Posição em steps
+    uint16_t	RampSpeed;		// Velocidade comandada pela rampa em steps/sec (TargetCurSpeed), ZERO sem rampa
+    uint16_t	CurDelay;		// Meio periodo actual do STEP em ticks do timer (0xFFFF = parado)
+    mstate_t	State;
+    mdir_t		Dir;
+} mstatus_t;
+typedef enum 	{trc_Cmd     = (int8_t) 1,		// comando aceite em __SetTargetSpeed, Data = velocidade pedida
+                 trc_Segment = (int8_t) 2,		// novo segmento da rampa (acelerar/desacelerar), Data = velocidade a atingir
+                 trc_Done    = (int8_t) 3,		// rampa terminada (__TargetSpeedDone), Data = estado final
+                 trc_DirFlip = (int8_t) 4,		// inversão do DIR no flanco do STEP, Data = nova direcção
+                 trc_MotorOn = (int8_t) 5,		// canal do STEP ligado, Data = CurDelay
+                 trc_MotorOff= (int8_t) 6,		// canal do STEP desligado, Data = 16 bits baixos da posição
+                 trc_Late    = (int8_t) 7,		// STEP atrasado (IRQ servida depois do proximo compare), Data = atraso em ticks
+                 trc_Micro   = (int8_t) 8		// mudança da resolução do microstepping, Data = microsteps por STEP
+                } mtrace_t;
+typedef struct {
+    uint32_t	Time;				// ciclos do CPU (DWT CYCCNT), o Tools/stptrace.c converte em ticks do timer
+    uint8_t		Event;			// mtrace_t
+    uint8_t		Motor;
+    uint16_t	Data;
+} mtrace_rec_t;
 #define MOTOR1  0
 #define MOTOR2  1
 
 //-----------------------------------------------------------------------------
 // Motors
-#define STPDRV_TIM          	TIM3
+#define STPDRV_TIM          	TIM3		// no STM32F2/F4 usar o TIM5 ou o TIM2 (32 bits, o TIM2 só sem STPDRV_USE_ENCODER), ver stm32f_stphal.h
+#define STPDRV_TIM_IRQn			TIM3_IRQn
+#define STPDRV_TIM_IRQHandler	TIM3_IRQHandler
 #define STPDRV_TIMFREQ        100000   // 200Khz reais uma vez que funciona em "togle", resolução final de 10us entre steps
-#define STPDRV_MINSETPSEC     2        // minimo de steps/sec, deve satisfazer a condição: STPDRV_TIMFREQ / STPDRV_MINSETPSEC < 65535
+#define STPDRV_MINSETPSEC     2        // minimo de steps/sec, deve satisfazer a condição: STPDRV_TIMFREQ / STPDRV_MINSETPSEC < 65535 (timer de 16 bits)
 #define STPDRV_MAXSETPSEC     1000     // maximo de steps/sec, deve satisfazer a condição: STPDRV_TIMFREQ / STPDRV_MAXSETPSEC > 100
+#define STPDRV_STARTSTOPSEC   50       // velocidade de arranque/paragem do motor (sem rampa), usada no arranque e na inversão de direcção
+#define STPDRV_DIRSETUP       1        // tempo minimo (em ticks do timer) entre a mudança do pino DIR e o proximo STEP
 #define STPDRV_TIM_APB      	RCC_APB1Periph_TIM3 // APB clock do timer usado
+#define STPDRV_SHAPER_LEN     64       // numero de amostras do historico do shaper por motor, potência de 2
+#define STPDRV_MAXBANDS       2        // numero maximo de bandas de ressonância por motor
+#define STPDRV_MS_FULL        16       // microsteps por full step na resolução mais fina (nivel 0), potência de 2
+#define STPDRV_MS_LEVELS      4        // numero maximo de resoluções do microstepping por motor, com a mais fina
 
 
 //-----------------------------------------------------------------------------
@@ -174,11 +418,41 @@ typedef enum 	{mstat_Stop  = (int8_t) 0, mstat_Move  = (int8_t) 1, mstat_GoTo  =
 void 		STPDRV_Init(void);
 void 		STPDRV_SetRamp(int16_t motor, int16_t rampspeed);
 int32_t 	STPDRV_GetPos(int16_t motor);
+void 		STPDRV_SetPos(int16_t motor, int32_t position);
+uint16_t 	STPDRV_GetSpeed(int16_t motor);
+uint16_t 	STPDRV_GetMaxSpeed(int16_t motor);
+void 		STPDRV_GetStatus(int16_t motor, mstatus_t *status);
 mdir_t 	STPDRV_GetDir(int16_t motor);
 mstate_t	STPDRV_GetState(int16_t motor);
 void 		STPDRV_Move(int16_t motor, mdir_t direction, int16_t speed);
 void 		STPDRV_Goto(int16_t motor, int32_t position, int16_t speed, mdir_t movedir);
 void 		STPDRV_Stop(int16_t motor, int16_t hardstop);
+#ifdef STPDRV_USE_SHAPER
+int16_t 	STPDRV_SetShaper(int16_t motor, mshaper_t type, uint16_t freq, uint16_t damping);
+#endif
+#ifdef STPDRV_USE_BANDS
+int16_t 	STPDRV_SetBand(int16_t motor, int16_t band, uint16_t low, uint16_t high, uint16_t slopmul);
+#endif
+#ifdef STPDRV_USE_ARC
+int16_t 	STPDRV_Arc(int32_t cx, int32_t cy, int32_t ex, int32_t ey, mdir_t dir, int16_t speed);
+#endif
+#ifdef STPDRV_USE_ENCODER
+void 		STPDRV_Inject(int16_t motor, uint16_t steps);
+#endif
+#ifdef STPDRV_USE_MICROSTEP
+int16_t 	STPDRV_SetMicrostep(int16_t motor, int16_t level, uint16_t mul, uint16_t pins, uint16_t up, uint16_t down);
+#endif
+#ifdef STPDRV_USE_RECORD
+int16_t 	STPDRV_RecStart(int16_t motor, uint8_t *buf, uint16_t size);
+uint16_t 	STPDRV_RecEnd(int16_t motor);
+int16_t 	STPDRV_Replay(int16_t motor, const uint8_t *buf, uint16_t len);
+#endif
+#ifdef STPDRV_USE_TRACE
+void 		STPDRV_TraceEnable(int16_t enable);
+uint16_t 	STPDRV_TraceDump(mtrace_rec_t *dst, uint16_t first, uint16_t max);
+uint16_t 	STPDRV_TraceCount(void);
+void 		STPDRV_TraceClear(void);
+#endif
 
 #endif  // __stm32f_stpdrv_h
 				  
@@ -0,0 +1,254 @@
+/*=============================================================================
+
+    @file    stm32f_stpenc.c
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   Quadrature encoder position check for the STM32F Stepper Driver
+
+   This Software is released under no garanty.
+    You may use this software for personal use.
+    Use for commercial and/or profit applications is strictly prohibited.
+
+    COPYRIGHT (C) 2026 STM32StepperDriver contributors
+
+   Compiled under C99 (ISO/IEC 9899:1999) version
+   please use the "--c99" compiler directive
+
+   Description and Usage: See stm32f_stpenc.h
+
+==============================================================================*/
+#include "stm32f_stpenc.h"
+
+#ifdef STPDRV_USE_ENCODER
+
+/* ===========================================================================*/
+/* Private structs and vars - DO NOT CHANGE !											*/
+/* ===========================================================================*/
+
+//---- Encoder struct
+typedef struct {
+    TIM_TypeDef		*Tim;				// ZERO = motor sem encoder
+    stpenc_cfg_t		Cfg;				// Cfg.Steps == 0 = ainda não configurado
+
+    // control fields - IGNORE THIS FIELDS
+    uint16_t			LastCnt;			// CNT do timer na ultima verificação
+    int32_t			Count;			// Contagem do encoder estendida a 32 bits
+    int32_t			CountZero;		// Count e posição do motor no STPENC_Zero()
+    int32_t			PosZero;
+    uint8_t			StallCnt;		// Verificações seguidas com o motor a andar e o encoder parado
+    uint8_t			LagCnt;			// Verificações seguidas com atraso acima do Deadband a corrigir
+    stpenc_status_t	Status;
+} TEnc;
+
+static TEnc Encs[2];
+
+// o timer de um encoder não pode ser o do driver (no STM32F2/F4 o STPDRV_TIM é o TIM5 ou o TIM2)
+#ifdef STPENC_M1_TIM
+typedef char STPENC_M1_TIM_igual_ao_STPDRV_TIM[(STPENC_M1_TIM_APB == STPDRV_TIM_APB) ? -1 : 1];
+#endif
+#ifdef STPENC_M2_TIM
+typedef char STPENC_M2_TIM_igual_ao_STPDRV_TIM[(STPENC_M2_TIM_APB == STPDRV_TIM_APB) ? -1 : 1];
+#endif
+
+
+//----- Private Function Prototypes - DO NOT USE
+static void 		__EncInit(TIM_TypeDef *tim);
+static void 		__EncRead(int16_t mt, int32_t *pos);
+
+//==============================================================================
+//
+void STPENC_Init(void)
+{
+    GPIO_InitTypeDef 	GPIO_InitStructure;
+
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IPU;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+
+#ifdef STPENC_M1_TIM
+    RCC_APB2PeriphClockCmd(STPENC_M1_PORT_APB, ENABLE);
+    RCC_APB1PeriphClockCmd(STPENC_M1_TIM_APB, ENABLE);		// USER EDIT - RCC_APB2PeriphClockCmd para o TIM1
+    GPIO_InitStructure.GPIO_Pin = STPENC_M1_PINS;
+    GPIO_Init(STPENC_M1_PORT, &GPIO_InitStructure);
+    __EncInit(STPENC_M1_TIM);
+    Encs[0].Tim = STPENC_M1_TIM;
+#endif
+#ifdef STPENC_M2_TIM
+    RCC_APB2PeriphClockCmd(STPENC_M2_PORT_APB, ENABLE);
+    RCC_APB1PeriphClockCmd(STPENC_M2_TIM_APB, ENABLE);
+    GPIO_InitStructure.GPIO_Pin = STPENC_M2_PINS;
+    GPIO_Init(STPENC_M2_PORT, &GPIO_InitStructure);
+    __EncInit(STPENC_M2_TIM);
+    Encs[1].Tim = STPENC_M2_TIM;
+#endif
+}
+//==============================================================================
+
+//==============================================================================
+//
+int16_t STPENC_Config(int16_t motor, const stpenc_cfg_t *cfg)
+{
+    if ((Encs[motor].Tim == 0) || (cfg->Counts == 0) || (cfg->Steps == 0))
+        return 0;
+
+    Encs[motor].Cfg = *cfg;
+    STPENC_Zero(motor);
+    return 1;
+}
+//==============================================================================
+
+//==============================================================================
+//
+void STPENC_Zero(int16_t motor)
+{
+    TEnc *en = &Encs[motor];
+    int32_t pos;
+
+    if (en->Tim == 0)
+        return;
+    __EncRead(motor, &pos);
+    en->CountZero		= en->Count;
+    en->PosZero			= pos;
+    en->StallCnt		= 0;
+    en->LagCnt			= 0;
+    en->Status.EncPos	= pos;
+    en->Status.Error	= 0;
+    en->Status.Flags	= 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Compara o encoder com a posição comandada. O erro é sempre calculado desde o
+//				 STPENC_Zero(), a divisão não acumula erros de arredondamento
+//
+void STPENC_Check(void)
+{
+    TEnc *en;
+    int32_t pos, last, enc, lag;
+    uint8_t flags;
+    uint16_t speed;
+    int16_t mt;
+
+    for (mt = 0; mt < 2; mt++) {
+        en = &Encs[mt];
+        if ((en->Tim == 0) || (en->Cfg.Steps == 0))
+            continue;
+
+        last = en->Count;
+        __EncRead(mt, &pos);
+        enc = (int32_t) (((int64_t) (en->Count - en->CountZero) * en->Cfg.Steps) / en->Cfg.Counts);
+        en->Status.EncPos	= en->PosZero + enc;
+        en->Status.Error	= enc - (pos - en->PosZero);
+        speed = STPDRV_GetSpeed(mt);
+        flags = en->Status.Flags;
+
+        // stall: o motor está comandado a andar e o encoder não se mexeu desde a ultima
+        // verificação. Os STEPs extra da correcção não mudam a velocidade comandada
+        if ((speed != 0) && (en->Count == last)) {
+            if (++en->StallCnt >= en->Cfg.StallChecks)
+                en->Status.Flags |= STPENC_STALL;
+        } else
+            en->StallCnt = 0;
+
+        if ((en->Status.Error > (int32_t) en->Cfg.MaxErr) || (en->Status.Error < -(int32_t) en->Cfg.MaxErr))
+            en->Status.Flags |= STPENC_FOLLOW;
+
+        // atraso no sentido do movimento, um erro positivo é atraso em dir_CCW
+        lag = (STPDRV_GetDir(mt) == dir_CW) ? -en->Status.Error : en->Status.Error;
+        if ((en->Cfg.Action & STPENC_ACT_INJECT) && (speed != 0)) {
+            STPDRV_Inject(mt, lag > (int32_t) en->Cfg.Deadband ? (uint16_t) (lag > 0xFFFF ? 0xFFFF : lag) : 0);
+            // a correcção não recupera o atraso, o motor não acompanha os STEPs extra
+            if (lag > (int32_t) en->Cfg.Deadband) {
+                if (++en->LagCnt >= en->Cfg.StallChecks)
+                    en->Status.Flags |= STPENC_FOLLOW;
+            } else
+                en->LagCnt = 0;
+        } else
+            en->LagCnt = 0;
+
+        if (en->Status.Flags == flags)
+            continue;		// sem falhas novas
+        if (en->Cfg.Action & STPENC_ACT_STOP)
+            STPDRV_Stop(mt, 1);
+        else if ((en->Cfg.Action & STPENC_ACT_SLOW) && (speed != 0) && (STPDRV_GetState(mt) == mstat_Move))
+            STPDRV_Move(mt, STPDRV_GetDir(mt), (int16_t) ((speed * 3) / 4));
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//
+void STPENC_GetStatus(int16_t motor, stpenc_status_t *status)
+{
+    *status = Encs[motor].Status;
+}
+//==============================================================================
+
+//==============================================================================
+//
+void STPENC_ClearFlags(int16_t motor)
+{
+    Encs[motor].Status.Flags	= 0;
+    Encs[motor].StallCnt		= 0;
+    Encs[motor].LagCnt		= 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Configura um timer em modo encoder nos canais 1 e 2, a contar nos dois flancos de
+//				ambos os canais (4 contagens por linha do encoder)
+//	params:	tim - timer
+//	return:	nada
+//
+static void __EncInit(TIM_TypeDef *tim)
+{
+    TIM_TimeBaseInitTypeDef  	TIM_TimeBaseStructure;
+    TIM_ICInitTypeDef 			TIM_ICInitStructure;
+
+    TIM_TimeBaseStructure.TIM_Period = 65535;
+    TIM_TimeBaseStructure.TIM_Prescaler = 0;
+    TIM_TimeBaseStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+    TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+    TIM_TimeBaseStructure.TIM_RepetitionCounter = 0x0000;
+    TIM_TimeBaseInit(tim, &TIM_TimeBaseStructure);
+
+    TIM_EncoderInterfaceConfig(tim, TIM_EncoderMode_TI12, TIM_ICPolarity_Rising, TIM_ICPolarity_Rising);
+    TIM_ICStructInit(&TIM_ICInitStructure);
+    TIM_ICInitStructure.TIM_ICFilter = STPENC_FILTER;
+    TIM_ICInitStructure.TIM_Channel = TIM_Channel_1;
+    TIM_ICInit(tim, &TIM_ICInitStructure);
+    TIM_ICInitStructure.TIM_Channel = TIM_Channel_2;
+    TIM_ICInit(tim, &TIM_ICInitStructure);
+
+    TIM_SetCounter(tim, 0);
+    TIM_Cmd(tim, ENABLE);
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Lê o encoder e a posição comandada no mesmo instante (com as IRQs desligadas) e
+//				estende a contagem do encoder a 32 bits
+//	params:	mt - motor
+//          pos - posição comandada
+//	return:	nada
+//
+static void __EncRead(int16_t mt, int32_t *pos)
+{
+    uint32_t primask;
+    uint16_t cnt;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    cnt = (uint16_t) Encs[mt].Tim->CNT;
+    *pos = STPDRV_GetPos(mt);
+    __set_PRIMASK(primask);
+
+    Encs[mt].Count += (int16_t) (cnt - Encs[mt].LastCnt);
+    Encs[mt].LastCnt = cnt;
+}
+//==============================================================================
+
+#endif  // STPDRV_USE_ENCODER
+
+//=============================================================================
+// EOF stm32f_stpenc.c
@@ -0,0 +1,159 @@
+/*=============================================================================
+
+	@file    stm32f_stpenc.h
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   Quadrature encoder position check for the STM32F Stepper Driver
+
+   This Software is released under no garanty.
+	You may use this software for personal use.
+	Use for commercial and/or profit applications is strictly prohibited.
+
+  	COPYRIGHT (C) 2026 STM32StepperDriver contributors
+
+   Compiled under C99 (ISO/IEC 9899:1999) version
+   please use the "--c99" compiler directive
+
+   ===================================================================
+	                    Description (in portuguese)
+   ===================================================================
+	- 	Lê um encoder em quadratura por motor com um timer em modo encoder (sem IRQs)
+	- 	Compara periodicamente a posição do encoder com a posição comandada (contador de passos)
+	- 	Detecta stall (motor comandado a andar e encoder parado) e following error (erro maior
+		que MaxErr, ou atraso que a correcção não recupera)
+	- 	Opcionalmente corrige os passos perdidos com STEPs extra (STPDRV_Inject), reduz a
+		velocidade ou pára o motor
+	- 	Só existe com STPDRV_USE_ENCODER definido em stm32f_stpdrv.h
+
+
+   ===================================================================
+                       How to use
+   ===================================================================
+	1 - Definir STPDRV_USE_ENCODER em stm32f_stpdrv.h e editar este ficheiro com os timers e pinos
+	2 - Chamar STPENC_Init() depois de STPDRV_Init()
+	3 - Chamar STPENC_Config(...) para cada motor com encoder e STPENC_Zero(...) com o motor parado
+		numa posição conhecida (por exemplo depois do homing)
+	4 - Chamar STPENC_Check() periodicamente, por exemplo com STPSCH_Add(STPENC_Check, 0, 10).
+		Entre duas verificações o encoder não pode andar mais de 32767 contagens e, à velocidade
+		minima, tem de andar pelo menos uma contagem em StallChecks verificações
+
+
+   ===================================================================
+                               API
+   ===================================================================
+	void STPENC_Init(void)
+			Descri: Inicializa os timers dos encoders
+			 Parms: 	none
+			Return: 	none
+
+
+	int16_t STPENC_Config(int16_t motor, const stpenc_cfg_t *cfg)
+			Descri: 	Define a relação encoder/motor, os limites e a acção em caso de falha
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+						cfg - ver stpenc_cfg_t
+			Return:  1 se OK, 0 se o motor não tiver encoder ou os parâmetros forem inválidos
+
+
+	void STPENC_Zero(int16_t motor)
+			Descri: 	Faz coincidir a posição do encoder com a posição actual do motor e apaga as falhas
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+			Return:  none
+
+
+	void STPENC_Check(void)
+			Descri: 	Verifica os encoders, chamar no ciclo principal a intervalos regulares
+			 Parms: 	none
+			Return:  none
+
+
+	void STPENC_GetStatus(int16_t motor, stpenc_status_t *status)
+			Descri: 	Para obter o resultado da ultima verificação
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+						status - estrutura a preencher
+			Return:  none
+
+
+	void STPENC_ClearFlags(int16_t motor)
+			Descri: 	Apaga as falhas (STPENC_STALL e STPENC_FOLLOW)
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+			Return:  none
+
+
+==============================================================================*/
+#ifndef  __stm32f_stpenc_h    // DO NOT CHANGE
+#define  __stm32f_stpenc_h    // DO NOT CHANGE
+
+#include "stm32f_stpdrv.h"
+
+#ifdef STPDRV_USE_ENCODER
+
+#include "stm32f_stphal.h"
+
+#ifdef STPHAL_F4
+#error "stm32f_stpenc: só STM32F10x (GPIO e clocks do StdPeriph do F1), ver stm32f_stphal.h"
+#endif
+
+// USER EDIT - Encoder do MOTOR1, canais 1 e 2 do timer (comentar STPENC_M1_TIM se não existir)
+#define STPENC_M1_TIM				TIM2
+#define STPENC_M1_TIM_APB		RCC_APB1Periph_TIM2
+#define STPENC_M1_PORT			GPIOA
+#define STPENC_M1_PORT_APB		RCC_APB2Periph_GPIOA
+#define STPENC_M1_PINS			(GPIO_Pin_0 | GPIO_Pin_1)
+
+// USER EDIT - Encoder do MOTOR2, descomentar se existir. O TIM4 (PB6/PB7) é também o timer da
+//					telemetria (stm32f_stptlm.h), que nesse caso deve usar outro timer
+//#define STPENC_M2_TIM				TIM4
+//#define STPENC_M2_TIM_APB		RCC_APB1Periph_TIM4
+//#define STPENC_M2_PORT			GPIOB
+//#define STPENC_M2_PORT_APB		RCC_APB2Periph_GPIOB
+//#define STPENC_M2_PINS			(GPIO_Pin_6 | GPIO_Pin_7)
+
+#define STPENC_FILTER				6			// filtro digital das entradas do encoder (0 a 15, ver TIMx_CCMR1 ICxF)
+
+
+/* ===========================================================================*/
+/* STOP ! - Private structs and vars - DO NOT CHANGE FROM THIS POINT ON 		*/
+/* ===========================================================================*/
+
+//---- Acções (stpenc_cfg_t.Action)
+#define STPENC_ACT_INJECT		0x01		// emitir STEPs extra para recuperar o atraso (ver STPDRV_Inject)
+#define STPENC_ACT_SLOW			0x02		// numa falha nova reduzir a velocidade para 3/4 (só em mstat_Move)
+#define STPENC_ACT_STOP			0x04		// numa falha nova parar o motor de imediato
+
+//---- Falhas (stpenc_status_t.Flags), ficam até STPENC_ClearFlags() ou STPENC_Zero()
+#define STPENC_STALL				0x01		// motor comandado a andar e o encoder parado
+#define STPENC_FOLLOW			0x02		// erro maior que MaxErr, ou atraso não recuperado pelo STPENC_ACT_INJECT
+
+typedef struct {
+    int16_t		Counts;			// contagens do encoder (4 por linha) em Steps passos, negativo inverte o sentido
+    uint16_t	Steps;
+    uint16_t	Deadband;		// erro em passos que não é corrigido (atraso normal do rotor)
+    uint16_t	MaxErr;			// erro em passos que dá STPENC_FOLLOW
+    uint8_t		StallChecks;	// verificações seguidas sem movimento do encoder para dar STPENC_STALL, ou com
+                                // atraso acima do Deadband (com STPENC_ACT_INJECT) para dar STPENC_FOLLOW
+    uint8_t		Action;			// STPENC_ACT_xxx
+} stpenc_cfg_t;
+
+typedef struct {
+    int32_t		EncPos;			// posição do encoder em passos
+    int32_t		Error;			// EncPos - posição comandada, em passos
+    uint8_t		Flags;			// STPENC_STALL, STPENC_FOLLOW
+} stpenc_status_t;
+
+
+//-----------------------------------------------------------------------------
+// Exported API Funcs
+void 		STPENC_Init(void);
+int16_t 	STPENC_Config(int16_t motor, const stpenc_cfg_t *cfg);
+void 		STPENC_Zero(int16_t motor);
+void 		STPENC_Check(void);
+void 		STPENC_GetStatus(int16_t motor, stpenc_status_t *status);
+void 		STPENC_ClearFlags(int16_t motor);
+
+#endif  // STPDRV_USE_ENCODER
+
+#endif  // __stm32f_stpenc_h
+
+//=============================================================================
+// EOF stm32f_stpenc.h
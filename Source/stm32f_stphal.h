@@ -0,0 +1,199 @@
+/*=============================================================================
+
+	@file    stm32f_stphal.h
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   Timer/GPIO access layer of the STM32F Stepper Driver
+
+   This Software is released under no garanty.
+	You may use this software for personal use.
+	Use for commercial and/or profit applications is strictly prohibited.
+
+  	COPYRIGHT (C) 2026 STM32StepperDriver contributors
+	O STPHAL_GpioClock e os acessos aos registos vêm do stm32f_stpdrv.c (__GPIO2AHB1Periph e
+	TIM3_IRQHandler), COPYRIGHT (C) 2013 Paulo de Almeida
+
+   Compiled under C99 (ISO/IEC 9899:1999) version
+   please use the "--c99" compiler directive
+
+   ===================================================================
+	                    Description (in portuguese)
+   ===================================================================
+	Tudo o que o stm32f_stpdrv.c faz directamente nos registos do timer e dos GPIO: armar e
+	recarregar um canal de compare, apagar a flag do canal e mudar os pinos. Só macros e
+	funções inline, na IRQ do STEP cada operação é a mesma escrita no registo que estava
+	escrita à mão.
+
+	O backend é escolhido pelos headers incluidos em stm32f_stpdrv.h:
+
+		STPHAL_F1	-	STM32F10x StdPeriph. Timer de 16 bits, pinos pelo BSRR/BRR, clocks no APB2
+		STPHAL_F4	-	STM32F2xx/F4xx StdPeriph (STM32F2XX, STM32F40XX, ...). STPDRV_TIM deve ser o
+						TIM5 ou o TIM2, de 32 bits (com STPDRV_USE_ENCODER o TIM5, o TIM2 fica
+						para o encoder do MOTOR1): o meio periodo do STEP (stphal_tick_t) passa a
+						32 bits e velocidades muito baixas não precisam de tratar a volta do
+						contador. Pinos pelo BSRRL/BSRRH, clocks no AHB1
+		STPHAL_HOST	-	Tools/host (PC), registos em RAM. Os pinos mudam o ODR e o IDR (o driver lê o
+						nivel do STEP no IDR) e a flag do canal é apagada sem mexer nas outras, a
+						IRQ do driver pode ser chamada directamente por um teste ou benchmark
+
+	Os outros modulos (stpenc, stphome, stpcom, stptlm) usam o StdPeriph do F1 directamente
+	(GPIO_Mode_xxx, EXTI pelo AFIO, canais de DMA, clocks no APB2) e só existem com o STPHAL_F1 e
+	o STPHAL_HOST, com o STPHAL_F4 os seus headers param a compilação com um #error. O driver
+	(e o STPDRV_Inject do STPDRV_USE_ENCODER) funciona no F4 sem eles.
+
+	As macros e funções são só para uso do stm32f_stpdrv.c, os outros modulos só usam os
+	STPHAL_F1/F4/HOST. "ch" é o numero do canal do STPDRV_TIM (1 a 4, constante).
+
+==============================================================================*/
+#ifndef  __stm32f_stphal_h    // DO NOT CHANGE
+#define  __stm32f_stphal_h    // DO NOT CHANGE
+
+#include "stm32f_stpdrv.h"
+
+//---- Backend
+#if defined(STM32F10X_HOST)
+#define STPHAL_HOST
+#elif defined(STM32F2XX) || defined(STM32F40XX) || defined(STM32F427X) || defined(STM32F429X) || \
+      defined(STM32F40_41xxx) || defined(STM32F427_437xx) || defined(STM32F429_439xx)
+#define STPHAL_F4
+#else
+#define STPHAL_F1
+#endif
+
+//---- Meio periodo do STEP em ticks do timer
+#ifdef STPHAL_F4
+typedef uint32_t				stphal_tick_t;
+#define STPHAL_TICK_MAX			0xFFFFFFFFUL
+#define STPHAL_TICKS(d)			((stphal_tick_t) (d))									// uint32_t para stphal_tick_t
+#define STPHAL_TICK16(d)		((d) > 0xFFFF ? (uint16_t) 0xFFFF : (uint16_t) (d))	// para o mstatus_t e o trace
+#else
+typedef uint16_t				stphal_tick_t;
+#define STPHAL_TICK_MAX			0xFFFFUL
+#define STPHAL_TICKS(d)			((d) > 0xFFFF ? (stphal_tick_t) 0xFFFF : (stphal_tick_t) (d))
+#define STPHAL_TICK16(d)		(d)
+#endif
+
+//---- Canais de compare
+#define STPHAL_CC_PENDING(ch)	((STPDRV_TIM->SR & TIM_IT_CC##ch) && (STPDRV_TIM->DIER & TIM_IT_CC##ch))
+#define STPHAL_CC_RELOAD(ch, d)	(STPDRV_TIM->CCR##ch += (d))
+#define STPHAL_CC_STOP(ch)		(STPDRV_TIM->DIER &= ~TIM_IT_CC##ch)
+// proximo compare já passou (IRQ servida tarde), chamar depois do STPHAL_CC_RELOAD
+#define STPHAL_CC_LATE(ch, d)	((stphal_tick_t) (STPDRV_TIM->CNT - STPDRV_TIM->CCR##ch + (d)) >= (d))
+#define STPHAL_CC_AGE(ch)		((stphal_tick_t) (STPDRV_TIM->CNT - STPDRV_TIM->CCR##ch))
+
+#ifdef STPHAL_HOST
+#define STPHAL_CC_CLEAR(ch)		(STPDRV_TIM->SR = (uint16_t) (STPDRV_TIM->SR & ~TIM_IT_CC##ch))
+#else
+#define STPHAL_CC_CLEAR(ch)		(STPDRV_TIM->SR = ~TIM_IT_CC##ch)				// rc_w0, as outras flags não mudam
+#endif
+
+// primeiro compare "d" ticks depois de agora, a flag fica activa dos compares com o canal desligado
+#define STPHAL_CC_ARM(ch, d)	do { STPDRV_TIM->CCR##ch = STPDRV_TIM->CNT + (d); STPHAL_CC_CLEAR(ch); \
+                                     STPDRV_TIM->DIER |= TIM_IT_CC##ch; } while (0)
+// liga o canal com um evento já (forçado pelo EGR)
+#define STPHAL_CC_FORCE(ch)		do { STPDRV_TIM->DIER |= TIM_IT_CC##ch; STPDRV_TIM->CCR##ch = STPDRV_TIM->CNT; \
+                                     STPDRV_TIM->EGR = TIM_EGR_CC##ch##G; } while (0)
+
+//---- Pinos
+#if defined(STPHAL_F4)
+#define STPHAL_PIN_SET(port, pin)			((port)->BSRRL = (pin))
+#define STPHAL_PIN_RESET(port, pin)		((port)->BSRRH = (pin))
+#define STPHAL_PIN_READ(port, pin)		((port)->IDR & (pin))
+// "pins" a HIGH e os outros de "mask" a LOW numa só escrita (BSRRL e BSRRH juntos)
+#define STPHAL_PIN_WRITE(port, mask, pins)	(*(__IO uint32_t *) &(port)->BSRRL = (pins) | ((uint32_t) ((mask) & ~(pins)) << 16))
+#elif defined(STPHAL_HOST)
+#define STPHAL_PIN_SET(port, pin)			do { (port)->ODR |= (pin); (port)->IDR = (port)->ODR; } while (0)
+#define STPHAL_PIN_RESET(port, pin)		do { (port)->ODR &= ~(uint32_t) (pin); (port)->IDR = (port)->ODR; } while (0)
+#define STPHAL_PIN_READ(port, pin)		((port)->IDR & (pin))
+#define STPHAL_PIN_WRITE(port, mask, pins)	do { (port)->ODR = ((port)->ODR & ~(uint32_t) (mask)) | (pins); \
+                                             (port)->IDR = (port)->ODR; } while (0)
+#else
+#define STPHAL_PIN_SET(port, pin)			((port)->BSRR = (pin))
+#define STPHAL_PIN_RESET(port, pin)		((port)->BRR = (pin))
+#define STPHAL_PIN_READ(port, pin)		((port)->IDR & (pin))
+#define STPHAL_PIN_WRITE(port, mask, pins)	((port)->BSRR = (pins) | ((uint32_t) ((mask) & ~(pins)) << 16))
+#endif
+
+
+//==============================================================================
+//	descri:  Liga o clock de um GPIO
+//	params:	port - GPIOA, GPIOB, ...
+//	return:	nada
+//
+static __INLINE void STPHAL_GpioClock(GPIO_TypeDef *port)
+{
+#ifdef STPHAL_F4
+    uint32_t clk = (uint32_t) 0x00;
+
+    if (port == GPIOA)
+        clk = RCC_AHB1Periph_GPIOA;
+    else if (port == GPIOB)
+        clk = RCC_AHB1Periph_GPIOB;
+    else if (port == GPIOC)
+        clk = RCC_AHB1Periph_GPIOC;
+    else if (port == GPIOD)
+        clk = RCC_AHB1Periph_GPIOD;
+    else if (port == GPIOE)
+        clk = RCC_AHB1Periph_GPIOE;
+    else if (port == GPIOF)
+        clk = RCC_AHB1Periph_GPIOF;
+    else if (port == GPIOG)
+        clk = RCC_AHB1Periph_GPIOG;
+    else if (port == GPIOH)
+        clk = RCC_AHB1Periph_GPIOH;
+    else if (port == GPIOI)
+        clk = RCC_AHB1Periph_GPIOI;
+    RCC_AHB1PeriphClockCmd(clk, ENABLE);
+#else
+    uint32_t clk = (uint32_t) 0x00;
+
+    if (port == GPIOA)
+        clk = RCC_APB2Periph_GPIOA;
+    else if (port == GPIOB)
+        clk = RCC_APB2Periph_GPIOB;
+    else if (port == GPIOC)
+        clk = RCC_APB2Periph_GPIOC;
+    else if (port == GPIOD)
+        clk = RCC_APB2Periph_GPIOD;
+    else if (port == GPIOE)
+        clk = RCC_APB2Periph_GPIOE;
+    else if (port == GPIOF)
+        clk = RCC_APB2Periph_GPIOF;
+#ifdef GPIOG
+    else if (port == GPIOG)
+        clk = RCC_APB2Periph_GPIOG;
+#endif
+    RCC_APB2PeriphClockCmd(clk, ENABLE);
+#endif
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Configura pinos como saídas push-pull, com o clock do GPIO
+//	params:	port - GPIOA, GPIOB, ...
+//          pins - GPIO_Pin_x (podem ser varios)
+//	return:	nada
+//
+static __INLINE void STPHAL_PinOut(GPIO_TypeDef *port, uint16_t pins)
+{
+    GPIO_InitTypeDef GPIO_InitStructure;
+
+    STPHAL_GpioClock(port);
+#ifdef STPHAL_F4
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_OUT;
+    GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
+    GPIO_InitStructure.GPIO_PuPd = GPIO_PuPd_DOWN;
+#else
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP;
+#endif
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_InitStructure.GPIO_Pin = pins;
+    GPIO_Init(port, &GPIO_InitStructure);
+}
+//==============================================================================
+
+#endif  // __stm32f_stphal_h
+
+//=============================================================================
+// EOF stm32f_stphal.h
@@ -0,0 +1,310 @@
+/*=============================================================================
+
+    @file    stm32f_stphome.c
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   Homing and limit switches for the STM32F Stepper Driver
+
+   This Software is released under no garanty.
+    You may use this software for personal use.
+    Use for commercial and/or profit applications is strictly prohibited.
+
+    COPYRIGHT (C) 2026 STM32StepperDriver contributors
+
+   Compiled under C99 (ISO/IEC 9899:1999) version
+   please use the "--c99" compiler directive
+
+   Description and Usage: See stm32f_stphome.h
+
+==============================================================================*/
+#include "stm32f_stphome.h"
+
+#ifdef STPDRV_USE_HOMING
+
+/* ===========================================================================*/
+/* Private structs and vars - DO NOT CHANGE !											*/
+/* ===========================================================================*/
+
+#define STPHOME_PIN(n)			((uint16_t) (1 << (n)))
+#define STPHOME_LINES			(STPHOME_PIN(STPHOME_M1_MIN) | STPHOME_PIN(STPHOME_M1_MAX) | \
+                              STPHOME_PIN(STPHOME_M2_MIN) | STPHOME_PIN(STPHOME_M2_MAX))
+
+//---- Home struct
+typedef struct {
+    stphome_cfg_t				Cfg;				// Cfg.FastSpeed == 0 = não configurado
+    __IO stphome_state_t	State;
+    __IO uint8_t				Limits;			// STPHOME_LIM_xxx que pararam o motor
+    __IO int32_t				LimitPos;		// Posição capturada no ultimo flanco
+    int32_t					RelPos;			// Posição onde o interruptor abriu no recuo
+    uint8_t					Released;		// 1 = o interruptor já abriu no recuo
+} THome;
+
+static THome Homes[2];
+
+// Pinos de cada motor, [motor][0 = MIN, 1 = MAX]
+static const uint8_t Pins[2][2] = {{STPHOME_M1_MIN, STPHOME_M1_MAX}, {STPHOME_M2_MIN, STPHOME_M2_MAX}};
+
+
+//----- Private Function Prototypes - DO NOT USE
+static void 		__OnSwitch(int16_t mt, uint8_t sw);
+static void 		__HomeStep(int16_t mt);
+static uint8_t 	__Active(int16_t mt, uint8_t sw);
+static uint8_t 	__HomeSw(int16_t mt);
+
+//==============================================================================
+//
+void STPHOME_Init(void)
+{
+    GPIO_InitTypeDef 	GPIO_InitStructure;
+    EXTI_InitTypeDef 	EXTI_InitStructure;
+    NVIC_InitTypeDef 	NVIC_InitStructure;
+    uint8_t mt, sw;
+
+    RCC_APB2PeriphClockCmd(STPHOME_PORT_APB | RCC_APB2Periph_AFIO, ENABLE);
+
+    GPIO_InitStructure.GPIO_Pin = STPHOME_LINES;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IPU;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_Init(STPHOME_PORT, &GPIO_InitStructure);
+
+    for (mt = 0; mt < 2; mt++)
+        for (sw = 0; sw < 2; sw++)
+            GPIO_EXTILineConfig(STPHOME_PORTSRC, Pins[mt][sw]);
+
+    EXTI_InitStructure.EXTI_Line = STPHOME_LINES;		// EXTI_Linex == GPIO_Pin_x
+    EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Interrupt;
+    EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Falling;
+    EXTI_InitStructure.EXTI_LineCmd = ENABLE;
+    EXTI_Init(&EXTI_InitStructure);
+    EXTI->PR = STPHOME_LINES;
+
+    // mesma prioridade da IRQ do driver, a paragem não é interrompida por um STEP
+    NVIC_InitStructure.NVIC_IRQChannel = STPHOME_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = IRQ_STPDRV_PrePriority;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = IRQ_STPDRV_Priority;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+}
+//==============================================================================
+
+//==============================================================================
+//
+void STPHOME_Config(int16_t motor, const stphome_cfg_t *cfg)
+{
+    Homes[motor].Cfg	= *cfg;
+    Homes[motor].State	= home_Idle;
+}
+//==============================================================================
+
+//==============================================================================
+//
+int16_t STPHOME_Start(int16_t motor)
+{
+    THome *hm = &Homes[motor];
+
+    if ((hm->Cfg.FastSpeed == 0) || ((hm->State >= home_Fast) && (hm->State <= home_Slow)))
+        return 0;
+
+    if (__Active(motor, __HomeSw(motor)))
+        hm->State = home_Stopping;		// já está no interruptor, começa pelo recuo
+    else {
+        hm->State = home_Fast;
+        STPDRV_Move(motor, hm->Cfg.Dir, (int16_t) hm->Cfg.FastSpeed);
+    }
+    return 1;
+}
+//==============================================================================
+
+//==============================================================================
+//
+void STPHOME_Poll(void)
+{
+    uint32_t primask;
+    int16_t mt;
+
+    for (mt = 0; mt < 2; mt++) {
+        // a IRQ dos interruptores também muda o estado
+        primask = __get_PRIMASK();
+        __disable_irq();
+        __HomeStep(mt);
+        __set_PRIMASK(primask);
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//
+stphome_state_t STPHOME_GetState(int16_t motor)
+{
+    return Homes[motor].State;
+}
+//==============================================================================
+
+//==============================================================================
+//
+uint8_t STPHOME_GetLimits(int16_t motor, int32_t *pos)
+{
+    if (pos)
+        *pos = Homes[motor].LimitPos;
+    return Homes[motor].Limits;
+}
+//==============================================================================
+
+//==============================================================================
+//
+void STPHOME_ClearLimits(int16_t motor)
+{
+    Homes[motor].Limits = 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   IRQ dos interruptores
+// USER EDIT - Mudar o nome do IRQ se os pinos forem alterados
+void EXTI15_10_IRQHandler(void)
+{
+    uint32_t pr = EXTI->PR & STPHOME_LINES;
+    int16_t mt;
+    uint8_t sw;
+
+    EXTI->PR = pr;
+    for (mt = 0; mt < 2; mt++)
+        for (sw = 0; sw < 2; sw++)
+            if (pr & STPHOME_PIN(Pins[mt][sw]))
+                __OnSwitch(mt, sw);
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Flanco de fecho de um interruptor. A posição é lida antes de tudo, é a posição no
+//				flanco a menos da latência da IRQ
+//	params:	mt - motor
+//          sw - 0 = MIN, 1 = MAX
+//	return:	nada
+//
+static void __OnSwitch(int16_t mt, uint8_t sw)
+{
+    THome *hm = &Homes[mt];
+    int32_t pos = STPDRV_GetPos(mt);
+
+    if (sw == __HomeSw(mt)) {
+        if (hm->State == home_Fast) {
+            hm->LimitPos = pos;
+            hm->State = home_Stopping;
+            STPDRV_Stop(mt, hm->Cfg.HardStop);
+            return;
+        }
+        if (hm->State == home_Slow) {
+            hm->LimitPos = pos;
+            STPDRV_Stop(mt, 1);
+            STPDRV_SetPos(mt, hm->Cfg.Offset + (STPDRV_GetPos(mt) - pos));
+            hm->State = home_Done;
+            return;
+        }
+        if (hm->State == home_Stopping)
+            return;			// ressaltos do interruptor durante a desaceleração
+    }
+
+    // fim de curso, só se o motor estiver a andar na direcção do interruptor
+    if ((STPDRV_GetSpeed(mt) != 0) && (STPDRV_GetDir(mt) == (sw ? dir_CW : dir_CCW))) {
+        STPDRV_Stop(mt, 1);
+        hm->LimitPos = pos;
+        hm->Limits |= sw ? STPHOME_LIM_MAX : STPHOME_LIM_MIN;
+        if ((hm->State >= home_Fast) && (hm->State <= home_Slow))
+            hm->State = home_Error;
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Avança o homing de um motor e verifica o nivel dos fins de curso. Chamada com as
+//				IRQs desligadas
+//	params:	mt - motor
+//	return:	nada
+//
+static void __HomeStep(int16_t mt)
+{
+    THome *hm = &Homes[mt];
+    uint8_t sw, homesw = __HomeSw(mt);
+    int32_t pos = STPDRV_GetPos(mt);
+    uint16_t speed = STPDRV_GetSpeed(mt);
+
+    switch (hm->State) {
+    case home_Fast:
+    case home_Slow:
+        if (speed == 0)
+            hm->State = home_Error;		// parou antes do interruptor
+        break;
+
+    case home_Stopping:
+        if (speed == 0) {
+            hm->Released = 0;
+            hm->State = home_Backoff;
+            STPDRV_Move(mt, hm->Cfg.Dir == dir_CW ? dir_CCW : dir_CW, (int16_t) hm->Cfg.SlowSpeed);
+        }
+        break;
+
+    case home_Backoff:
+        if (speed == 0) {
+            hm->State = home_Error;
+            break;
+        }
+        if (__Active(mt, homesw))
+            break;
+        if (!hm->Released) {
+            hm->Released = 1;
+            hm->RelPos = pos;
+        } else if ((pos - hm->RelPos >= (int32_t) hm->Cfg.Backoff) || (hm->RelPos - pos >= (int32_t) hm->Cfg.Backoff)) {
+            STPDRV_Stop(mt, 1);
+            hm->State = home_Slow;
+            STPDRV_Move(mt, hm->Cfg.Dir, (int16_t) hm->Cfg.SlowSpeed);
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    // fins de curso por nivel, para um movimento começado com o interruptor já fechado
+    for (sw = 0; sw < 2; sw++) {
+        if ((sw == homesw) && ((hm->State == home_Fast) || (hm->State == home_Stopping) || (hm->State == home_Slow)))
+            continue;
+        if (__Active(mt, sw) && (STPDRV_GetSpeed(mt) != 0) && (STPDRV_GetDir(mt) == (sw ? dir_CW : dir_CCW))) {
+            STPDRV_Stop(mt, 1);
+            hm->LimitPos = STPDRV_GetPos(mt);
+            hm->Limits |= sw ? STPHOME_LIM_MAX : STPHOME_LIM_MIN;
+            if ((hm->State >= home_Fast) && (hm->State <= home_Slow))
+                hm->State = home_Error;
+        }
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Para saber se um interruptor está fechado
+//	params:	mt - motor
+//          sw - 0 = MIN, 1 = MAX
+//	return:	1 se fechado
+//
+static uint8_t __Active(int16_t mt, uint8_t sw)
+{
+    return (STPHOME_PORT->IDR & STPHOME_PIN(Pins[mt][sw])) == 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:  Interruptor usado no homing
+//	params:	mt - motor
+//	return:	0 = MIN, 1 = MAX
+//
+static uint8_t __HomeSw(int16_t mt)
+{
+    return Homes[mt].Cfg.Dir == dir_CW ? 1 : 0;
+}
+//==============================================================================
+
+#endif  // STPDRV_USE_HOMING
+
+//=============================================================================
+// EOF stm32f_stphome.c
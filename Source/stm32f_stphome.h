@@ -0,0 +1,160 @@
+/*=============================================================================
+
+	@file    stm32f_stphome.h
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   Homing and limit switches for the STM32F Stepper Driver
+
+   This Software is released under no garanty.
+	You may use this software for personal use.
+	Use for commercial and/or profit applications is strictly prohibited.
+
+  	COPYRIGHT (C) 2026 STM32StepperDriver contributors
+
+   Compiled under C99 (ISO/IEC 9899:1999) version
+   please use the "--c99" compiler directive
+
+   ===================================================================
+	                    Description (in portuguese)
+   ===================================================================
+	- 	Dois interruptores por motor: MIN (fim do lado dir_CCW) e MAX (fim do lado dir_CW)
+	- 	O flanco do interruptor dá um EXTI que captura a posição nesse instante e pára o motor
+		logo ali, sem depender da frequência com que o ciclo principal corre
+	- 	Um fim de curso só pára o motor se ele estiver a andar na sua direcção, pode-se sempre
+		sair de um fim de curso
+	- 	Homing com aproximação rápida, recuo e nova aproximação lenta, a posição de home é a
+		capturada no flanco da aproximação lenta
+	- 	Só existe com STPDRV_USE_HOMING definido em stm32f_stpdrv.h
+
+	Os interruptores ligam o pino à massa (pull-up interno), o flanco descendente é o fecho.
+
+	A posição é capturada por software na IRQ do EXTI e não por input capture: os 4 canais do
+	STPDRV_TIM são do driver, uma captura noutro timer dava o instante do flanco e não a contagem
+	de steps, e os pinos PB12-15 não são entradas de timer. A IRQ do EXTI tem a prioridade da IRQ
+	do driver, a posição lida só difere da do flanco se a IRQ do driver já estiver a correr nesse
+	instante e der um STEP (no maximo 1 step).
+
+
+   ===================================================================
+                       How to use
+   ===================================================================
+	1 - Definir STPDRV_USE_HOMING em stm32f_stpdrv.h e editar este ficheiro com os pinos
+	2 - Chamar STPHOME_Init() depois de STPDRV_Init()
+	3 - Chamar STPHOME_Config(...) para os motores com homing
+	4 - Chamar STPHOME_Poll() periodicamente, por exemplo com STPSCH_Add(STPHOME_Poll, 0, 5)
+	5 - STPHOME_Start(...) e esperar por home_Done em STPHOME_GetState(...)
+
+
+   ===================================================================
+                               API
+   ===================================================================
+	void STPHOME_Init(void)
+			Descri: Inicializa os pinos e os EXTI dos interruptores
+			 Parms: 	none
+			Return: 	none
+
+
+	void STPHOME_Config(int16_t motor, const stphome_cfg_t *cfg)
+			Descri: 	Define o homing de um motor
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+						cfg - ver stphome_cfg_t
+			Return:  none
+
+
+	int16_t STPHOME_Start(int16_t motor)
+			Descri: 	Começa o homing (não bloqueia)
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+			Return:  1 se começou, 0 se o motor não estiver configurado ou já estiver em homing
+
+
+	void STPHOME_Poll(void)
+			Descri: 	Avança o homing e verifica o nivel dos fins de curso (para o caso de um motor
+						arrancar com o interruptor já fechado), chamar no ciclo principal
+			 Parms: 	none
+			Return:  none
+
+
+	stphome_state_t STPHOME_GetState(int16_t motor)
+			Descri: 	Para saber o estado do homing
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+			Return:  home_Idle, home_Fast, home_Stopping, home_Backoff, home_Slow, home_Done ou
+						home_Error (o motor parou antes de encontrar o interruptor)
+
+
+	uint8_t STPHOME_GetLimits(int16_t motor, int32_t *pos)
+			Descri: 	Para saber que fins de curso pararam o motor desde o ultimo STPHOME_ClearLimits()
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+						pos - posição capturada no ultimo flanco (pode ser ZERO)
+			Return:  STPHOME_LIM_MIN e/ou STPHOME_LIM_MAX
+
+
+	void STPHOME_ClearLimits(int16_t motor)
+			Descri: 	Apaga os fins de curso registados
+			 Parms: 	motor - motor em questão, MOTOR1 ou MOTOR2
+			Return:  none
+
+
+==============================================================================*/
+#ifndef  __stm32f_stphome_h    // DO NOT CHANGE
+#define  __stm32f_stphome_h    // DO NOT CHANGE
+
+#include "stm32f_stpdrv.h"
+
+#ifdef STPDRV_USE_HOMING
+
+#include "stm32f_stphal.h"
+
+#ifdef STPHAL_F4
+#error "stm32f_stphome: só STM32F10x (EXTI pelo AFIO e GPIO do StdPeriph do F1), ver stm32f_stphal.h"
+#endif
+
+#include <stm32f10x_exti.h>
+
+// USER EDIT - Pinos dos interruptores, todos no mesmo port e nas linhas 10 a 15 do EXTI (uma só IRQ)
+#define STPHOME_PORT				GPIOB
+#define STPHOME_PORT_APB			RCC_APB2Periph_GPIOB
+#define STPHOME_PORTSRC			GPIO_PortSourceGPIOB
+#define STPHOME_M1_MIN			12			// numero do pino
+#define STPHOME_M1_MAX			13
+#define STPHOME_M2_MIN			14
+#define STPHOME_M2_MAX			15
+#define STPHOME_IRQn				EXTI15_10_IRQn		// USER EDIT - mudar também o nome da IRQ no .c
+
+
+/* ===========================================================================*/
+/* STOP ! - Private structs and vars - DO NOT CHANGE FROM THIS POINT ON 		*/
+/* ===========================================================================*/
+
+#define STPHOME_LIM_MIN			0x01
+#define STPHOME_LIM_MAX			0x02
+
+typedef enum 	{home_Idle = (int8_t) 0, home_Fast = (int8_t) 1, home_Stopping = (int8_t) 2, home_Backoff = (int8_t) 3,
+                 home_Slow = (int8_t) 4, home_Done = (int8_t) 5, home_Error = (int8_t) 6} stphome_state_t;
+
+typedef struct {
+    mdir_t		Dir;				// sentido do home: dir_CCW usa o interruptor MIN, dir_CW o MAX
+    uint16_t	FastSpeed;		// velocidade da primeira aproximação em steps/sec
+    uint16_t	SlowSpeed;		// velocidade do recuo e da segunda aproximação, de preferência <= STPDRV_STARTSTOPSEC
+    uint16_t	Backoff;			// passos a recuar depois de o interruptor abrir
+    int32_t		Offset;			// posição atribuida ao ponto de home
+    uint8_t		HardStop;		// 1 = paragem imediata na aproximação rápida, 0 = com desaceleração
+} stphome_cfg_t;
+
+
+//-----------------------------------------------------------------------------
+// Exported API Funcs
+void 		STPHOME_Init(void);
+void 		STPHOME_Config(int16_t motor, const stphome_cfg_t *cfg);
+int16_t 	STPHOME_Start(int16_t motor);
+void 		STPHOME_Poll(void);
+stphome_state_t STPHOME_GetState(int16_t motor);
+uint8_t 	STPHOME_GetLimits(int16_t motor, int32_t *pos);
+void 		STPHOME_ClearLimits(int16_t motor);
+
+#endif  // STPDRV_USE_HOMING
+
+#endif  // __stm32f_stphome_h
+
+//=============================================================================
+// EOF stm32f_stphome.h
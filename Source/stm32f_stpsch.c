@@ -0,0 +1,198 @@
+/*=============================================================================
+
+    @file    stm32f_stpsch.c
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   SysTick cooperative scheduler for the STM32F Stepper Driver application
+
+   This Software is released under no garanty.
+    You may use this software for personal use.
+    Use for commercial and/or profit applications is strictly prohibited.
+
+    COPYRIGHT (C) 2026 STM32StepperDriver contributors
+
+   Compiled under C99 (ISO/IEC 9899:1999) version
+   please use the "--c99" compiler directive
+
+   Description and Usage: See stm32f_stpsch.h
+
+==============================================================================*/
+#include "stm32f_stpsch.h"
+
+/* ===========================================================================*/
+/* Private structs and vars - DO NOT CHANGE !											*/
+/* ===========================================================================*/
+
+//---- Task struct
+typedef struct {
+    void			(*Task)(void);		// NULL = entrada livre
+    uint32_t		Next;					// tick da próxima execução
+    uint32_t		Period;				// 0 = one-shot
+} TTask;
+
+static TTask 				Tasks[STPSCH_MAXTASKS];
+static __IO uint32_t 	Ticks;
+static uint32_t 			TicksPerUs;
+static uint32_t 			Late;
+
+//----- Private Function Prototypes - DO NOT USE
+static uint16_t 	__RunDue(uint32_t now);
+
+//==============================================================================
+//
+void STPSCH_Init(void)
+{
+    uint16_t i;
+
+    for (i = 0; i < STPSCH_MAXTASKS; i++)
+        Tasks[i].Task = 0;
+    Ticks = 0;
+    Late = 0;
+    TicksPerUs = SystemCoreClock / 1000000;
+
+    // SysTick com a prioridade mais baixa, nunca atrasa as IRQ do driver
+    SysTick_Config(SystemCoreClock / STPSCH_TICKFREQ);
+}
+//==============================================================================
+
+//==============================================================================
+//
+int16_t STPSCH_Add(void (*task)(void), uint32_t delay, uint32_t period)
+{
+    int16_t i;
+
+    for (i = 0; i < STPSCH_MAXTASKS; i++) {
+        if (Tasks[i].Task == 0) {
+            Tasks[i].Next = Ticks + delay;
+            Tasks[i].Period = period;
+            Tasks[i].Task = task;
+            return i;
+        }
+    }
+    return -1;
+}
+//==============================================================================
+
+//==============================================================================
+//
+void STPSCH_Remove(int16_t id)
+{
+    if ((id >= 0) && (id < STPSCH_MAXTASKS))
+        Tasks[id].Task = 0;
+}
+//==============================================================================
+
+//==============================================================================
+//
+void STPSCH_Run(void)
+{
+    uint32_t now;
+    uint16_t ran;
+
+    while (1) {
+        now = Ticks;
+        ran = __RunDue(now);
+
+        // com as IRQ desligadas o WFI acorda na mesma com um interrupt pendente,
+        // um tick entre a verificação e o WFI não se perde
+        __disable_irq();
+        if (!ran && (now == Ticks))
+            __WFI();
+        __enable_irq();
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//
+uint32_t STPSCH_Millis(void)
+{
+    return Ticks;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   microsegundos do Ticks mais a parte já contada pelo SysTick
+//
+uint32_t STPSCH_Micros(void)
+{
+    uint32_t ms, val;
+
+    do {
+        ms = Ticks;
+        val = SysTick->VAL;
+    } while (ms != Ticks);
+
+    // chamada com a IRQ do SysTick pendente (dentro de outra IRQ), o Ticks ainda não avançou
+    if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) && (val > (SysTick->LOAD >> 1)))
+        ms++;
+
+    return ms * (1000000 / STPSCH_TICKFREQ) + (SysTick->LOAD - val) / TicksPerUs;
+}
+//==============================================================================
+
+//==============================================================================
+//
+void STPSCH_DelayUs(uint32_t us)
+{
+    uint32_t start = STPSCH_Micros();
+
+    while ((STPSCH_Micros() - start) < us)
+        ;
+}
+//==============================================================================
+
+//==============================================================================
+//
+uint32_t STPSCH_GetLate(void)
+{
+    return Late;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Uma passagem pela tabela, executa as tarefas com o tempo atingido. Uma tarefa
+//				 one-shot é apagada antes de correr e uma periódica já tem o Next seguinte, a
+//				 tarefa pode remover-se ou adicionar-se de novo
+//	params:	now - Ticks lido no inicio da passagem
+//	return:	1 se alguma tarefa correu
+//
+static uint16_t __RunDue(uint32_t now)
+{
+    uint32_t late;
+    uint16_t i, ran = 0;
+    void (*task)(void);
+
+    for (i = 0; i < STPSCH_MAXTASKS; i++) {
+        task = Tasks[i].Task;
+        if ((task == 0) || ((int32_t) (now - Tasks[i].Next) < 0))
+            continue;
+
+        late = now - Tasks[i].Next;
+        if (late > Late)
+            Late = late;
+        if (Tasks[i].Period == 0)
+            Tasks[i].Task = 0;
+        else if (late >= Tasks[i].Period)
+            Tasks[i].Next = now + Tasks[i].Period;		// perdeu execuções, não tenta recuperar
+        else
+            Tasks[i].Next += Tasks[i].Period;
+        task();
+        ran = 1;
+    }
+    return ran;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   IRQ do SysTick, base de tempo do scheduler
+//
+void SysTick_Handler(void)
+{
+    Ticks++;
+}
+//==============================================================================
+
+//=============================================================================
+// EOF stm32f_stpsch.c
@@ -0,0 +1,124 @@
+/*=============================================================================
+
+	@file    stm32f_stpsch.h
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   SysTick cooperative scheduler for the STM32F Stepper Driver application
+
+   This Software is released under no garanty.
+	You may use this software for personal use.
+	Use for commercial and/or profit applications is strictly prohibited.
+
+  	COPYRIGHT (C) 2026 STM32StepperDriver contributors
+
+   Compiled under C99 (ISO/IEC 9899:1999) version
+   please use the "--c99" compiler directive
+
+   ===================================================================
+	                    Description (in portuguese)
+   ===================================================================
+	- 	Scheduler cooperativo para a aplicação à volta do driver (protocolo, telemetria, etc)
+	- 	Tarefas periódicas e one-shot com tempos em milisegundos, base de tempo no SysTick
+	- 	Relógio em milisegundos e microsegundos lido do SysTick (sem timer extra)
+	- 	Sem tarefas para correr o core fica em WFI até ao próximo interrupt
+	- 	As tarefas correm no ciclo principal, as IRQ do driver têm sempre prioridade
+
+
+   ===================================================================
+                       How to use
+   ===================================================================
+	1 - Chamar STPSCH_Init() depois de inicializar o clock do sistema
+	2 - Adicionar as tarefas com STPSCH_Add()
+	3 - Chamar STPSCH_Run() no fim do main(), não retorna
+
+	As tarefas não podem bloquear, fazem o trabalho e retornam.
+
+
+   ===================================================================
+                               API
+   ===================================================================
+	void STPSCH_Init(void)
+			Descri: Inicializa o SysTick e a tabela de tarefas
+			 Parms: 	none
+			Return: 	none
+
+
+	int16_t STPSCH_Add(void (*task)(void), uint32_t delay, uint32_t period)
+			Descri: 	Adiciona uma tarefa
+			 Parms: 	task - função da tarefa
+						delay - milisegundos até à primeira execução
+						period - milisegundos entre execuções, 0 para uma tarefa one-shot
+			Return:  id da tarefa ou -1 se a tabela estiver cheia
+
+
+	void STPSCH_Remove(int16_t id)
+			Descri: 	Remove uma tarefa (pode ser chamada dentro da própria tarefa)
+			 Parms: 	id - devolvido por STPSCH_Add()
+			Return:  none
+
+
+	void STPSCH_Run(void)
+			Descri: 	Ciclo do scheduler, executa as tarefas no seu tempo e faz WFI quando não há
+						nada para fazer. Não retorna
+			 Parms: 	none
+			Return:  none
+
+
+	uint32_t STPSCH_Millis(void)
+			Descri: 	Para obter o tempo desde o STPSCH_Init()
+			 Parms: 	none
+			Return:  milisegundos (dá a volta aos 49 dias)
+
+
+	uint32_t STPSCH_Micros(void)
+			Descri: 	Para obter o tempo desde o STPSCH_Init()
+			 Parms: 	none
+			Return:  microsegundos (dá a volta aos 71 minutos)
+
+
+	void STPSCH_DelayUs(uint32_t us)
+			Descri: 	Espera activa para tempos curtos (pulsos, setup de drivers), não usar
+						para esperas longas, para essas usar uma tarefa one-shot
+			 Parms: 	us - microsegundos
+			Return:  none
+
+
+	uint32_t STPSCH_GetLate(void)
+			Descri: 	Para saber o maior atraso de uma tarefa em relação ao seu tempo
+			 Parms: 	none
+			Return:  milisegundos
+
+
+==============================================================================*/
+#ifndef  __stm32f_stpsch_h    // DO NOT CHANGE
+#define  __stm32f_stpsch_h    // DO NOT CHANGE
+
+#include "stm32f_stpdrv.h"
+
+
+// USER EDIT - Edit the lines below to reflect your application
+#define STPSCH_MAXTASKS			8			// numero maximo de tarefas
+#define STPSCH_TICKFREQ			1000		// frequência do SysTick, 1 ms
+
+
+/* ===========================================================================*/
+/* STOP ! - Private structs and vars - DO NOT CHANGE FROM THIS POINT ON 		*/
+/* ===========================================================================*/
+
+
+//-----------------------------------------------------------------------------
+// Exported API Funcs
+void 		STPSCH_Init(void);
+int16_t 	STPSCH_Add(void (*task)(void), uint32_t delay, uint32_t period);
+void 		STPSCH_Remove(int16_t id);
+void 		STPSCH_Run(void);
+uint32_t 	STPSCH_Millis(void);
+uint32_t 	STPSCH_Micros(void);
+void 		STPSCH_DelayUs(uint32_t us);
+uint32_t 	STPSCH_GetLate(void);
+
+#endif  // __stm32f_stpsch_h
+
+//=============================================================================
+// EOF stm32f_stpsch.h
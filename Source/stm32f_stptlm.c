@@ -0,0 +1,177 @@
+/*=============================================================================
+
+    @file    stm32f_stptlm.c
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   Telemetry stream for the STM32F Stepper Driver
+
+   This Software is released under no garanty.
+    You may use this software for personal use.
+    Use for commercial and/or profit applications is strictly prohibited.
+
+    COPYRIGHT (C) 2026 STM32StepperDriver contributors
+
+   Compiled under C99 (ISO/IEC 9899:1999) version
+   please use the "--c99" compiler directive
+
+   Description and Usage: See stm32f_stptlm.h
+
+==============================================================================*/
+#include "stm32f_stptlm.h"
+
+/* ===========================================================================*/
+/* Private structs and vars - DO NOT CHANGE !											*/
+/* ===========================================================================*/
+
+//---- Sample struct
+typedef struct {
+    uint16_t		Tick;				// numero da amostragem
+    uint8_t		Motor;
+    mstatus_t	Status;
+} TSample;
+
+//---- Buffer circular, Head escrito na IRQ do timer, Tail no ciclo principal
+static TSample 			Samples[STPTLM_SIZE];
+static __IO uint16_t 	Head;
+static __IO uint16_t 	Tail;
+static __IO uint32_t 	Dropped;
+static uint16_t 			Tick;
+static uint8_t 			Mask;
+
+//==============================================================================
+//
+void STPTLM_Init(void)
+{
+    TIM_TimeBaseInitTypeDef  	TIM_TimeBaseStructure;
+    NVIC_InitTypeDef 				NVIC_InitStructure;
+
+    Head = Tail = 0;
+    Dropped = 0;
+    Mask = 0;
+
+    RCC_APB1PeriphClockCmd(STPTLM_TIM_APB, ENABLE);
+
+    TIM_TimeBaseStructure.TIM_Period = STPTLM_TICKFREQ / 100 - 1;
+    TIM_TimeBaseStructure.TIM_Prescaler = (uint16_t) (STPTLM_TIMCLK / STPTLM_TICKFREQ) - 1;
+    TIM_TimeBaseStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+    TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+    TIM_TimeBaseStructure.TIM_RepetitionCounter = 0x0000;
+    TIM_TimeBaseInit(STPTLM_TIM, &TIM_TimeBaseStructure);
+
+    // mesma prioridade da IRQ do driver, a IRQ do STEP não interrompe a leitura de uma amostra
+    NVIC_InitStructure.NVIC_IRQChannel = STPTLM_TIM_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = IRQ_STPDRV_PrePriority;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = IRQ_STPDRV_Priority;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+}
+//==============================================================================
+
+//==============================================================================
+//
+void STPTLM_Start(uint16_t rate, uint8_t mask)
+{
+    if ((rate == 0) || (rate > STPTLM_TICKFREQ))
+        return;
+
+    TIM_Cmd(STPTLM_TIM, DISABLE);
+    Mask = mask;
+    STPTLM_TIM->ARR = (uint16_t) (STPTLM_TICKFREQ / rate - 1);
+    STPTLM_TIM->CNT = 0;
+    STPTLM_TIM->SR = ~TIM_IT_Update;
+    STPTLM_TIM->DIER |= TIM_IT_Update;
+    TIM_Cmd(STPTLM_TIM, ENABLE);
+}
+//==============================================================================
+
+//==============================================================================
+//
+void STPTLM_Stop(void)
+{
+    TIM_Cmd(STPTLM_TIM, DISABLE);
+    STPTLM_TIM->DIER &= ~TIM_IT_Update;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   IRQ da amostragem, guarda uma amostra por motor ou conta-a como perdida
+// USER EDIT - Mudar o nome do IRQ se o TIMER for alterado
+void TIM4_IRQHandler(void)
+{
+    uint16_t h;
+    uint8_t m;
+
+    if (STPTLM_TIM->SR & TIM_IT_Update) {
+        STPTLM_TIM->SR = ~TIM_IT_Update;
+        Tick++;
+        for (m = 0; m < 2; m++) {
+            if ((Mask & (1 << m)) == 0)
+                continue;
+            h = Head;
+            if (((h + 1) & (STPTLM_SIZE - 1)) == Tail) {
+                Dropped++;
+                continue;
+            }
+            Samples[h].Tick = Tick;
+            Samples[h].Motor = m;
+            STPDRV_GetStatus(m, &Samples[h].Status);
+            Head = (h + 1) & (STPTLM_SIZE - 1);
+        }
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//
+void STPTLM_Poll(void)
+{
+    uint8_t p[2 + STPTLM_PERFRAME * 11], *q;
+    uint16_t t, n;
+    uint32_t d;
+    TSample *s;
+
+    for (;;) {
+        t = Tail;
+        // fica sempre espaço para a resposta mais longa a um comando (STPCOM_REPLY_ROOM), a
+        // telemetria não atrasa as respostas. Sem espaço as amostras ficam no buffer, se
+        // encher são contadas em Dropped
+        if ((t == Head) || (STPCOM_TxFree() < sizeof(p) + STPCOM_REPLY_ROOM))
+            return;
+
+        d = Dropped;
+        p[0] = (uint8_t) d;
+        p[1] = (uint8_t) (d >> 8);
+        q = &p[2];
+        for (n = 0; (n < STPTLM_PERFRAME) && (((t + n) & (STPTLM_SIZE - 1)) != Head); n++) {
+            s = &Samples[(t + n) & (STPTLM_SIZE - 1)];
+            *q++ = (uint8_t) s->Tick;
+            *q++ = (uint8_t) (s->Tick >> 8);
+            *q++ = (uint8_t) (s->Motor | ((s->Status.Dir & 1) << 1) | (s->Status.State << 2));
+            *q++ = (uint8_t) s->Status.Pos;
+            *q++ = (uint8_t) (s->Status.Pos >> 8);
+            *q++ = (uint8_t) (s->Status.Pos >> 16);
+            *q++ = (uint8_t) (s->Status.Pos >> 24);
+            *q++ = (uint8_t) s->Status.RampSpeed;
+            *q++ = (uint8_t) (s->Status.RampSpeed >> 8);
+            *q++ = (uint8_t) s->Status.CurDelay;
+            *q++ = (uint8_t) (s->Status.CurDelay >> 8);
+        }
+
+        if (!STPCOM_Send(STPCOM_TLM_SAMPLES, p, (uint8_t) (q - p)))
+            return;
+        Tail = (t + n) & (STPTLM_SIZE - 1);
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//
+uint32_t STPTLM_GetDropped(void)
+{
+    return Dropped;
+}
+//==============================================================================
+
+//=============================================================================
+// EOF stm32f_stptlm.c
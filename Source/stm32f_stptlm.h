@@ -0,0 +1,116 @@
+/*=============================================================================
+
+	@file    stm32f_stptlm.h
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   Telemetry stream for the STM32F Stepper Driver
+
+   This Software is released under no garanty.
+	You may use this software for personal use.
+	Use for commercial and/or profit applications is strictly prohibited.
+
+  	COPYRIGHT (C) 2026 STM32StepperDriver contributors
+
+   Compiled under C99 (ISO/IEC 9899:1999) version
+   please use the "--c99" compiler directive
+
+   ===================================================================
+	                    Description (in portuguese)
+   ===================================================================
+	- 	Amostragem periódica do estado de cada motor (posição, TargetCurSpeed, CurDelay, estado
+		e direcção) num timer próprio, para um buffer circular em RAM
+	- 	O buffer é enviado pela USART do protocolo (stm32f_stpcom) por DMA, sem bloquear. A
+		telemetria deixa sempre no buffer de transmissão espaço para uma resposta a um comando
+	- 	Se o buffer encher as amostras são descartadas e contadas, o contador vai em cada frame
+
+
+   ===================================================================
+                       Frame format
+   ===================================================================
+	Frames do protocolo stm32f_stpcom com CMD = STPCOM_TLM_SAMPLES e o payload:
+
+	[dropped u16] [amostra] ... (até STPTLM_PERFRAME amostras)
+
+	amostra (11 bytes):	tick u16, flags u8, pos i32, rampspeed u16, curdelay u16
+		tick - contador de amostragens do timer (mesmo valor para os motores da mesma amostragem)
+		flags - bit 0: motor, bit 1: direcção, bits 2..7: estado (mstate_t)
+		dropped - total de amostras descartadas (16 bits baixos)
+
+
+   ===================================================================
+                               API
+   ===================================================================
+	void STPTLM_Init(void)
+			Descri: Inicializa o timer da amostragem (parado)
+			 Parms: 	none
+			Return: 	none
+
+
+	void STPTLM_Start(uint16_t rate, uint8_t mask)
+			Descri: 	Começa a amostragem
+			 Parms: 	rate - amostragens por segundo (1 a 10000)
+						mask - motores a amostrar, bit 0 = MOTOR1, bit 1 = MOTOR2
+			Return:  none
+
+
+	void STPTLM_Stop(void)
+			Descri: 	Pára a amostragem, as amostras em buffer continuam a ser enviadas
+			 Parms: 	none
+			Return:  none
+
+
+	void STPTLM_Poll(void)
+			Descri: 	Envia as amostras em buffer (chamar no ciclo principal, não bloqueia)
+			 Parms: 	none
+			Return:  none
+
+
+	uint32_t STPTLM_GetDropped(void)
+			Descri: 	Para obter o total de amostras descartadas por falta de espaço
+			 Parms: 	none
+			Return:  numero de amostras
+
+
+==============================================================================*/
+#ifndef  __stm32f_stptlm_h    // DO NOT CHANGE
+#define  __stm32f_stptlm_h    // DO NOT CHANGE
+
+#include "stm32f_stpdrv.h"
+#include "stm32f_stphal.h"
+
+#ifdef STPHAL_F4
+#error "stm32f_stptlm: só STM32F10x (usa o stm32f_stpcom), ver stm32f_stphal.h"
+#endif
+
+#include "stm32f_stpcom.h"
+
+
+// USER EDIT - Edit the lines below to reflect your hardware
+#define STPTLM_TIM				TIM4
+#define STPTLM_TIM_APB			RCC_APB1Periph_TIM4
+#define STPTLM_TIM_IRQn			TIM4_IRQn						// USER EDIT - mudar também o nome da IRQ no .c
+#define STPTLM_TIMCLK			SystemCoreClock				// clock do timer, ver RCC (no STM32F100 com APB1 /1 é o SystemCoreClock)
+
+
+/* ===========================================================================*/
+/* STOP ! - Private structs and vars - DO NOT CHANGE FROM THIS POINT ON 		*/
+/* ===========================================================================*/
+
+#define STPTLM_SIZE				64			// amostras no buffer circular, potência de 2
+#define STPTLM_PERFRAME			2			// amostras por frame
+#define STPTLM_TICKFREQ			10000		// frequência do contador do timer
+
+
+//-----------------------------------------------------------------------------
+// Exported API Funcs
+void 		STPTLM_Init(void);
+void 		STPTLM_Start(uint16_t rate, uint8_t mask);
+void 		STPTLM_Stop(void);
+void 		STPTLM_Poll(void);
+uint32_t 	STPTLM_GetDropped(void);
+
+#endif  // __stm32f_stptlm_h
+
+//=============================================================================
+// EOF stm32f_stptlm.h
@@ -0,0 +1,129 @@
+/*=============================================================================
+
+    @file    hostsim.h (host)
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   STPDRV_TIM simulado no PC, corre a IRQ do driver em cada compare
+
+   COPYRIGHT (C) 2026 STM32StepperDriver contributors
+
+   Incluir depois do stm32f_stpdrv.c. O tempo salta de compare em compare: o proximo evento de
+   cada canal sai do CCR e do DIER do STPDRV_TIM (e do EGR nos eventos forçados), em cada evento
+   o CNT é posto no instante do compare, a flag do canal é posta no SR e é chamada a
+   STPDRV_TIM_IRQHandler. Os pinos mudam pelo backend STPHAL_HOST do stm32f_stphal.h.
+
+   Depois de cada chamada à API do driver chamar SIM_Sync(), o driver pode ter ligado,
+   desligado ou recarregado canais.
+
+   Os pinos STEP e DIR têm de ser todos diferentes, no stm32f_stpdrv.h de exemplo não são: a
+   ferramenta inclui o stm32f_stpdrv.h, muda os MOTORx_DIR_PIN e só depois inclui o
+   stm32f_stpdrv.c.
+
+==============================================================================*/
+#ifndef  __host_hostsim_h
+#define  __host_hostsim_h
+
+#include <string.h>
+
+#define SIM_TICKS				((uint64_t) STPDRV_TIMFREQ * 2)	// ticks do timer por segundo
+
+static uint64_t SimNow;				// tempo em ticks do timer
+static uint64_t SimNext[4];			// proximo compare de cada canal
+static uint64_t SimEvents[4];		// eventos de cada canal
+static uint16_t SimArmed;			// canais com SimNext[] válido
+
+//==============================================================================
+//	descri:   CCR de um canal (0 a 3)
+//
+static __IO uint16_t *SIM_Ccr(int c)
+{
+    return &STPDRV_TIM->CCR1 + c;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Timer e pinos a zero, chamar antes do STPDRV_Init()
+//
+static void SIM_Reset(void)
+{
+    memset((void *) HostTIM, 0, sizeof(HostTIM));
+    memset((void *) HostGPIO, 0, sizeof(HostGPIO));
+    memset(SimEvents, 0, sizeof(SimEvents));
+    SimArmed = 0;
+    SimNow = 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Recalcula os proximos compares a partir dos CCR, do DIER e do EGR depois de
+//				 correr código do driver
+//
+static void SIM_Sync(void)
+{
+    uint16_t d, m;
+    int c;
+
+    for (c = 0; c < 4; c++) {
+        m = (uint16_t) (TIM_IT_CC1 << c);
+        if (!(STPDRV_TIM->DIER & m)) {
+            SimArmed &= (uint16_t) ~m;
+            continue;
+        }
+        if (STPDRV_TIM->EGR & m)
+            SimNext[c] = SimNow;			// evento forçado, servido já
+        else if (!(SimArmed & m) || (*SIM_Ccr(c) != (uint16_t) SimNext[c])) {
+            // CCR novo, um compare igual ao CNT só dá na volta seguinte
+            d = (uint16_t) (*SIM_Ccr(c) - (uint16_t) SimNow);
+            SimNext[c] = SimNow + (d ? d : 65536);
+        }
+        SimArmed |= m;
+    }
+    STPDRV_TIM->EGR = 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   CNT do timer (e o CYCCNT do trace, a SystemCoreClock) no instante SimNow
+//
+static void SIM_Clock(void)
+{
+    STPDRV_TIM->CNT = (uint16_t) SimNow;
+#ifdef STPDRV_USE_TRACE
+    STPDRV_CYCCNT = (uint32_t) (SimNow * SystemCoreClock / SIM_TICKS);
+#endif
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Serve o proximo compare, se for antes de "limit"
+//	return:	canal servido (0 a 3), -1 se não houver compares antes de "limit" (o tempo
+//				 passa para "limit")
+//
+static int SIM_Event(uint64_t limit)
+{
+    int c, best = -1;
+
+    for (c = 0; c < 4; c++)
+        if ((SimArmed & (TIM_IT_CC1 << c)) && ((best < 0) || (SimNext[c] < SimNext[best])))
+            best = c;
+    if ((best < 0) || (SimNext[best] >= limit)) {
+        SimNow = limit;
+        SIM_Clock();
+        return -1;
+    }
+    SimNow = SimNext[best];
+    SIM_Clock();
+    STPDRV_TIM->SR = (uint16_t) (STPDRV_TIM->SR | (TIM_IT_CC1 << best));
+    STPDRV_TIM_IRQHandler();
+    SimEvents[best]++;
+    SimArmed &= (uint16_t) ~(TIM_IT_CC1 << best);		// o CCR foi recarregado pela IRQ
+    SIM_Sync();
+    return best;
+}
+//==============================================================================
+
+#endif  // __host_hostsim_h
+
+//=============================================================================
+// EOF hostsim.h (host)
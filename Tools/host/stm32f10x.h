@@ -0,0 +1,331 @@
+/*=============================================================================
+
+    @file    stm32f10x.h (host)
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   Registos e StdPeriph minimos para compilar o driver no PC
+
+   COPYRIGHT (C) 2026 STM32StepperDriver contributors
+
+   Só o que o stm32f_stpdrv.c e os módulos da aplicação usam, para as ferramentas em Tools/
+   (ver stpplan.c e stptest.c). Os periféricos são variáveis em RAM e as funções de
+   inicialização não fazem nada, o tempo é simulado a partir dos CCR e do DIER pelo
+   hostsim.h, que corre a IRQ do driver. A USART e o DMA do stm32f_stpcom.c são simulados
+   no stptest.c, que escreve no buffer do DMA RX e esvazia o do TX.
+
+==============================================================================*/
+#ifndef  __host_stm32f10x_h
+#define  __host_stm32f10x_h
+
+#include <stdint.h>
+
+// os registos de endereço do DMA têm 32 bits, os ponteiros do PC não cabem (o DMA simulado não os usa)
+#ifndef __cplusplus
+#pragma GCC diagnostic ignored "-Wpointer-to-int-cast"
+#endif
+
+#define STM32F10X_HOST								// backend STPHAL_HOST do stm32f_stphal.h
+#define __IO						volatile
+#define __INLINE					inline
+
+typedef enum {DISABLE = 0, ENABLE = !DISABLE} FunctionalState;
+
+//---- Registos
+#ifdef __cplusplus
+// Em C++ o SR é rc_w0 como no timer: escrever 0 apaga a flag, escrever 1 não muda nada. Para
+// pôr flags usar .Flags
+struct HostSR {
+    uint16_t Flags;
+    operator uint16_t() const volatile { return Flags; }
+    void operator=(uint16_t w) volatile { Flags &= w; }
+};
+#define __HOST_SR					volatile HostSR
+#else
+#define __HOST_SR					__IO uint16_t
+#endif
+
+typedef struct {
+    __IO uint16_t	CR1, CR2, SMCR, DIER;
+    __HOST_SR		SR;
+    __IO uint16_t	EGR, CCMR1, CCMR2, CCER, CNT, PSC, ARR, RCR;
+    __IO uint16_t	CCR1, CCR2, CCR3, CCR4;
+} TIM_TypeDef;
+
+typedef struct {
+    __IO uint32_t	CRL, CRH, IDR, ODR, BSRR, BRR, LCKR;
+} GPIO_TypeDef;
+
+typedef struct {
+    __IO uint16_t	SR, DR, BRR, CR1, CR2, CR3, GTPR;
+} USART_TypeDef;
+
+typedef struct {
+    __IO uint32_t	CCR, CNDTR, CPAR, CMAR;
+} DMA_Channel_TypeDef;
+
+// IFCR não apaga as flags do ISR sozinho, quem simula o DMA aplica-o depois da IRQ
+typedef struct {
+    __IO uint32_t	ISR, IFCR;
+} DMA_TypeDef;
+
+// PR não é rc_w1 no PC, a IRQ escreve e o teste põe os bits dos flancos
+typedef struct {
+    __IO uint32_t	IMR, EMR, RTSR, FTSR, SWIER, PR;
+} EXTI_TypeDef;
+
+typedef struct {
+    __IO uint32_t	CTRL, LOAD, VAL, CALIB;
+} SysTick_Type;
+
+typedef struct {
+    __IO uint32_t	CPUID, ICSR;
+} SCB_Type;
+
+extern TIM_TypeDef 	HostTIM[4];
+extern GPIO_TypeDef 	HostGPIO[6];
+extern uint32_t 		SystemCoreClock;
+extern uint32_t 		HostDWT[3];				// DEMCR, DWT_CTRL e CYCCNT do trace (STPDRV_USE_TRACE)
+extern USART_TypeDef 	HostUSART[1];			// só nas ferramentas com o stm32f_stpcom.c
+extern DMA_TypeDef 		HostDMA[1];
+extern DMA_Channel_TypeDef HostDMACh[7];
+extern EXTI_TypeDef 	HostEXTI;				// só nas ferramentas com o stm32f_stphome.c
+extern SysTick_Type 	HostSysTick;			// só nas ferramentas com o stm32f_stpsch.c
+extern SCB_Type 			HostSCB;
+
+#define STPDRV_DEMCR				HostDWT[0]
+#define STPDRV_DWT_CTRL			HostDWT[1]
+#define STPDRV_CYCCNT			HostDWT[2]
+
+#define TIM2						(&HostTIM[1])
+#define TIM3						(&HostTIM[2])
+#define TIM4						(&HostTIM[3])
+#define GPIOA						(&HostGPIO[0])
+#define GPIOB						(&HostGPIO[1])
+#define GPIOC						(&HostGPIO[2])
+#define GPIOD						(&HostGPIO[3])
+#define GPIOE						(&HostGPIO[4])
+#define GPIOF						(&HostGPIO[5])
+#define USART1					(&HostUSART[0])
+#define DMA1						(&HostDMA[0])
+#define DMA1_Channel4			(&HostDMACh[3])
+#define DMA1_Channel5			(&HostDMACh[4])
+
+#define EXTI						(&HostEXTI)
+#define SysTick					(&HostSysTick)
+#define SCB							(&HostSCB)
+#define SCB_ICSR_PENDSTSET_Msk	((uint32_t) 1 << 26)
+
+#define DMA_CCR1_EN				((uint32_t) 0x00000001)
+#define DMA_ISR_TCIF4			((uint32_t) 0x00002000)
+#define DMA_ISR_TCIF5			((uint32_t) 0x00020000)
+#define DMA_IFCR_CGIF4			((uint32_t) 0x00001000)
+#define DMA_IFCR_CGIF5			((uint32_t) 0x00010000)
+
+#define TIM_IT_Update			((uint16_t) 0x0001)
+#define TIM_IT_CC1				((uint16_t) 0x0002)
+#define TIM_IT_CC2				((uint16_t) 0x0004)
+#define TIM_IT_CC3				((uint16_t) 0x0008)
+#define TIM_IT_CC4				((uint16_t) 0x0010)
+#define TIM_EGR_CC1G				((uint16_t) 0x0002)
+#define TIM_EGR_CC2G				((uint16_t) 0x0004)
+#define TIM_EGR_CC3G				((uint16_t) 0x0008)
+#define TIM_EGR_CC4G				((uint16_t) 0x0010)
+
+#define GPIO_Pin_0				((uint16_t) 0x0001)
+#define GPIO_Pin_1				((uint16_t) 0x0002)
+#define GPIO_Pin_2				((uint16_t) 0x0004)
+#define GPIO_Pin_3				((uint16_t) 0x0008)
+#define GPIO_Pin_4				((uint16_t) 0x0010)
+#define GPIO_Pin_5				((uint16_t) 0x0020)
+#define GPIO_Pin_6				((uint16_t) 0x0040)
+#define GPIO_Pin_7				((uint16_t) 0x0080)
+#define GPIO_Pin_8				((uint16_t) 0x0100)
+#define GPIO_Pin_9				((uint16_t) 0x0200)
+#define GPIO_Pin_10				((uint16_t) 0x0400)
+#define GPIO_Pin_11				((uint16_t) 0x0800)
+#define GPIO_Pin_12				((uint16_t) 0x1000)
+#define GPIO_Pin_13				((uint16_t) 0x2000)
+#define GPIO_Pin_14				((uint16_t) 0x4000)
+#define GPIO_Pin_15				((uint16_t) 0x8000)
+
+#define RCC_APB2Periph_AFIO		((uint32_t) 0x00000001)
+#define RCC_APB2Periph_GPIOA	((uint32_t) 0x00000004)
+#define RCC_APB2Periph_GPIOB	((uint32_t) 0x00000008)
+#define RCC_APB2Periph_GPIOC	((uint32_t) 0x00000010)
+#define RCC_APB2Periph_GPIOD	((uint32_t) 0x00000020)
+#define RCC_APB2Periph_GPIOE	((uint32_t) 0x00000040)
+#define RCC_APB2Periph_GPIOF	((uint32_t) 0x00000080)
+#define RCC_APB1Periph_TIM2		((uint32_t) 0x00000001)
+#define RCC_APB1Periph_TIM3		((uint32_t) 0x00000002)
+#define RCC_APB1Periph_TIM4		((uint32_t) 0x00000004)
+#define RCC_APB2Periph_USART1	((uint32_t) 0x00004000)
+#define RCC_AHBPeriph_DMA1		((uint32_t) 0x00000001)
+
+typedef enum {DMA1_Channel4_IRQn = 14, DMA1_Channel5_IRQn = 15, TIM2_IRQn = 28, TIM3_IRQn = 29,
+              TIM4_IRQn = 30, EXTI15_10_IRQn = 40} IRQn_Type;
+
+#define GPIO_PortSourceGPIOA	((uint8_t) 0x00)
+#define GPIO_PortSourceGPIOB	((uint8_t) 0x01)
+
+//---- StdPeriph, só as estruturas e constantes usadas no STPDRV_Init()
+typedef enum {GPIO_Speed_10MHz = 1, GPIO_Speed_2MHz, GPIO_Speed_50MHz} GPIOSpeed_TypeDef;
+typedef enum {GPIO_Mode_IN_FLOATING = 0x04, GPIO_Mode_IPU = 0x48, GPIO_Mode_Out_PP = 0x10,
+              GPIO_Mode_AF_PP = 0x18} GPIOMode_TypeDef;
+typedef struct {
+    uint16_t				GPIO_Pin;
+    GPIOSpeed_TypeDef	GPIO_Speed;
+    GPIOMode_TypeDef		GPIO_Mode;
+} GPIO_InitTypeDef;
+
+typedef struct {
+    uint8_t		NVIC_IRQChannel;
+    uint8_t		NVIC_IRQChannelPreemptionPriority;
+    uint8_t		NVIC_IRQChannelSubPriority;
+    FunctionalState	NVIC_IRQChannelCmd;
+} NVIC_InitTypeDef;
+
+typedef struct {
+    uint16_t	TIM_Prescaler;
+    uint16_t	TIM_CounterMode;
+    uint16_t	TIM_Period;
+    uint16_t	TIM_ClockDivision;
+    uint8_t		TIM_RepetitionCounter;
+} TIM_TimeBaseInitTypeDef;
+
+typedef struct {
+    uint16_t	TIM_OCMode;
+    uint16_t	TIM_OutputState;
+    uint16_t	TIM_OutputNState;
+    uint16_t	TIM_Pulse;
+    uint16_t	TIM_OCPolarity;
+    uint16_t	TIM_OCNPolarity;
+    uint16_t	TIM_OCIdleState;
+    uint16_t	TIM_OCNIdleState;
+} TIM_OCInitTypeDef;
+
+typedef struct {
+    uint32_t	DMA_PeripheralBaseAddr;
+    uint32_t	DMA_MemoryBaseAddr;
+    uint32_t	DMA_DIR;
+    uint32_t	DMA_BufferSize;
+    uint32_t	DMA_PeripheralInc;
+    uint32_t	DMA_MemoryInc;
+    uint32_t	DMA_PeripheralDataSize;
+    uint32_t	DMA_MemoryDataSize;
+    uint32_t	DMA_Mode;
+    uint32_t	DMA_Priority;
+    uint32_t	DMA_M2M;
+} DMA_InitTypeDef;
+
+typedef enum {EXTI_Mode_Interrupt = 0x00, EXTI_Mode_Event = 0x04} EXTIMode_TypeDef;
+typedef enum {EXTI_Trigger_Rising = 0x08, EXTI_Trigger_Falling = 0x0C} EXTITrigger_TypeDef;
+typedef struct {
+    uint32_t				EXTI_Line;
+    EXTIMode_TypeDef		EXTI_Mode;
+    EXTITrigger_TypeDef	EXTI_Trigger;
+    FunctionalState		EXTI_LineCmd;
+} EXTI_InitTypeDef;
+
+typedef struct {
+    uint32_t	USART_BaudRate;
+    uint16_t	USART_WordLength;
+    uint16_t	USART_StopBits;
+    uint16_t	USART_Parity;
+    uint16_t	USART_Mode;
+    uint16_t	USART_HardwareFlowControl;
+} USART_InitTypeDef;
+
+#define DMA_DIR_PeripheralSRC	((uint32_t) 0x00000000)
+#define DMA_DIR_PeripheralDST	((uint32_t) 0x00000010)
+#define DMA_PeripheralInc_Disable	((uint32_t) 0x00000000)
+#define DMA_MemoryInc_Enable	((uint32_t) 0x00000080)
+#define DMA_PeripheralDataSize_Byte	((uint32_t) 0x00000000)
+#define DMA_MemoryDataSize_Byte	((uint32_t) 0x00000000)
+#define DMA_Mode_Circular		((uint32_t) 0x00000020)
+#define DMA_Mode_Normal			((uint32_t) 0x00000000)
+#define DMA_Priority_High		((uint32_t) 0x00002000)
+#define DMA_Priority_Medium		((uint32_t) 0x00001000)
+#define DMA_M2M_Disable			((uint32_t) 0x00000000)
+#define DMA_IT_TC				((uint32_t) 0x00000002)
+
+#define USART_WordLength_8b		((uint16_t) 0x0000)
+#define USART_StopBits_1			((uint16_t) 0x0000)
+#define USART_Parity_No			((uint16_t) 0x0000)
+#define USART_Mode_Rx			((uint16_t) 0x0004)
+#define USART_Mode_Tx			((uint16_t) 0x0008)
+#define USART_HardwareFlowControl_None	((uint16_t) 0x0000)
+#define USART_DMAReq_Tx			((uint16_t) 0x0080)
+#define USART_DMAReq_Rx			((uint16_t) 0x0040)
+
+#define TIM_CKD_DIV1				((uint16_t) 0x0000)
+#define TIM_CounterMode_Up		((uint16_t) 0x0000)
+#define TIM_OCMode_Timing		((uint16_t) 0x0000)
+#define TIM_OutputState_Disable	((uint16_t) 0x0000)
+#define TIM_OCPolarity_High		((uint16_t) 0x0000)
+#define TIM_OCPreload_Disable	((uint16_t) 0x0000)
+
+static __INLINE void SystemCoreClockUpdate(void) {}
+static __INLINE void RCC_APB1PeriphClockCmd(uint32_t p, FunctionalState s) {(void) p; (void) s;}
+static __INLINE void RCC_APB2PeriphClockCmd(uint32_t p, FunctionalState s) {(void) p; (void) s;}
+static __INLINE void GPIO_Init(GPIO_TypeDef *g, GPIO_InitTypeDef *i) {(void) g; (void) i;}
+static __INLINE void NVIC_Init(NVIC_InitTypeDef *i) {(void) i;}
+static __INLINE void GPIO_EXTILineConfig(uint8_t port, uint8_t pin) {(void) port; (void) pin;}
+static __INLINE void EXTI_Init(EXTI_InitTypeDef *i)
+{
+    HostEXTI.IMR |= i->EXTI_Line;
+    HostEXTI.FTSR |= i->EXTI_Line;
+}
+static __INLINE void TIM_TimeBaseInit(TIM_TypeDef *t, TIM_TimeBaseInitTypeDef *i) {(void) t; (void) i;}
+static __INLINE void TIM_UpdateDisableConfig(TIM_TypeDef *t, FunctionalState s) {(void) t; (void) s;}
+static __INLINE void TIM_OCStructInit(TIM_OCInitTypeDef *i) {(void) i;}
+static __INLINE void TIM_OC1Init(TIM_TypeDef *t, TIM_OCInitTypeDef *i) {(void) t; (void) i;}
+static __INLINE void TIM_OC2Init(TIM_TypeDef *t, TIM_OCInitTypeDef *i) {(void) t; (void) i;}
+static __INLINE void TIM_OC3Init(TIM_TypeDef *t, TIM_OCInitTypeDef *i) {(void) t; (void) i;}
+static __INLINE void TIM_OC4Init(TIM_TypeDef *t, TIM_OCInitTypeDef *i) {(void) t; (void) i;}
+static __INLINE void TIM_OC1PreloadConfig(TIM_TypeDef *t, uint16_t p) {(void) t; (void) p;}
+static __INLINE void TIM_OC2PreloadConfig(TIM_TypeDef *t, uint16_t p) {(void) t; (void) p;}
+static __INLINE void TIM_OC3PreloadConfig(TIM_TypeDef *t, uint16_t p) {(void) t; (void) p;}
+static __INLINE void TIM_OC4PreloadConfig(TIM_TypeDef *t, uint16_t p) {(void) t; (void) p;}
+static __INLINE void TIM_Cmd(TIM_TypeDef *t, FunctionalState s) {(void) t; (void) s;}
+static __INLINE void RCC_AHBPeriphClockCmd(uint32_t p, FunctionalState s) {(void) p; (void) s;}
+static __INLINE void USART_Init(USART_TypeDef *u, USART_InitTypeDef *i) {(void) u; (void) i;}
+static __INLINE void USART_DMACmd(USART_TypeDef *u, uint16_t r, FunctionalState s) {(void) u; (void) r; (void) s;}
+static __INLINE void USART_Cmd(USART_TypeDef *u, FunctionalState s) {(void) u; (void) s;}
+static __INLINE void DMA_ITConfig(DMA_Channel_TypeDef *c, uint32_t i, FunctionalState s) {(void) c; (void) i; (void) s;}
+
+//---- DMA, o CNDTR e o modo ficam como no chip (o RX circular começa com o tamanho do buffer)
+static __INLINE void DMA_DeInit(DMA_Channel_TypeDef *c)
+{
+    c->CCR = c->CNDTR = c->CPAR = c->CMAR = 0;
+}
+static __INLINE void DMA_Init(DMA_Channel_TypeDef *c, DMA_InitTypeDef *i)
+{
+    c->CCR = i->DMA_DIR | i->DMA_Mode | i->DMA_MemoryInc | i->DMA_Priority;
+    c->CNDTR = i->DMA_BufferSize;
+    c->CPAR = i->DMA_PeripheralBaseAddr;
+    c->CMAR = i->DMA_MemoryBaseAddr;
+}
+static __INLINE void DMA_Cmd(DMA_Channel_TypeDef *c, FunctionalState s)
+{
+    c->CCR = s ? (c->CCR | DMA_CCR1_EN) : (c->CCR & ~DMA_CCR1_EN);
+}
+
+//---- CMSIS, o PC não tem IRQs
+static __INLINE uint32_t __get_PRIMASK(void) {return 0;}
+static __INLINE void __set_PRIMASK(uint32_t m) {(void) m;}
+static __INLINE void __disable_irq(void) {}
+static __INLINE void __enable_irq(void) {}
+static __INLINE void __WFI(void) {}
+static __INLINE uint32_t SysTick_Config(uint32_t ticks)
+{
+    HostSysTick.LOAD = ticks - 1;
+    HostSysTick.VAL = 0;
+    HostSysTick.CTRL = 7;
+    return 0;
+}
+
+#endif  // __host_stm32f10x_h
+
+//=============================================================================
+// EOF stm32f10x.h (host)
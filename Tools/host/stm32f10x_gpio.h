@@ -0,0 +1,2 @@
+// host: tudo em stm32f10x.h
+#include "stm32f10x.h"
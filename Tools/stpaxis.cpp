@@ -0,0 +1,260 @@
+/*=============================================================================
+
+    @file    stpaxis.cpp
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   Host size/cycle check of stm32f_stpaxis.hpp against the macro ISR
+
+   This Software is released under no garanty.
+    You may use this software for personal use.
+    Use for commercial and/or profit applications is strictly prohibited.
+
+    COPYRIGHT (C) 2026 STM32StepperDriver contributors
+    Partes baseadas no stm32f_stpdrv.c (IRQ do STEP e rampas), COPYRIGHT (C) 2013 Paulo de Almeida
+
+   ===================================================================
+	                    Description (in portuguese)
+   ===================================================================
+	Compara no PC a IRQ de dois eixos feita com os templates do stm32f_stpaxis.hpp com a
+	mesma IRQ escrita à mão com as macros MOTORx_xxx e testes ao indice do motor, como no
+	TIM3_IRQHandler do driver. Os registos são os de Tools/host.
+
+		1 - as duas IRQs correm a mesma sequência de eventos (canais, inversões do DIR e
+			 mudanças de velocidade) e o estado final tem de ser igual
+		2 - tamanho do código de cada IRQ (sem as funções de inversão do DIR, que não são
+			 inline nas duas versões), o AxisIsr não pode ser maior que o MacroIsr
+		3 - tempo de cada IRQ em ns por evento, descontado o custo do ciclo de teste. É o tempo
+			 no PC (x86), só serve para comparar as duas versões entre si, não diz nada dos
+			 ciclos no Cortex-M
+
+	Compilar:	g++ -std=c++11 -O2 -Ihost -o stpaxis stpaxis.cpp
+
+	Usar:		stpaxis [eventos]
+
+	O programa sai com 1 se o estado final for diferente ou se o AxisIsr for maior. Cada IRQ
+	fica numa secção própria e o tamanho sai dos simbolos __start_/__stop_ da secção, que o
+	linker da GNU (e o lld) cria em ELF. O mesmo tamanho vê-se com:
+		nm -C -S --size-sort stpaxis | grep Isr
+
+	Para o alvo compilar o mesmo ficheiro com o arm-none-eabi-g++ -mcpu=cortex-m3 -mthumb -Os
+	e os headers do StdPeriph em vez de -Ihost, e comparar os tamanhos da mesma forma.
+
+==============================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Uma secção por IRQ para o tamanho do código, o linker cria os __start_ e __stop_
+#define STPAXIS_SECTION(s)		__attribute__((noinline, section(s)))
+extern "C" const char __start_stpaxis_macro[], __stop_stpaxis_macro[];
+extern "C" const char __start_stpaxis_axis[], __stop_stpaxis_axis[];
+
+#define STPAXIS_GPIO(n)			(&HostGPIO[n])
+#define STPAXIS_TIM(n)			(&HostTIM[(n) + 1])
+#include "../Source/stm32f_stpaxis.hpp"
+
+TIM_TypeDef 	HostTIM[4];
+GPIO_TypeDef 	HostGPIO[6];
+uint32_t 		SystemCoreClock = 24000000;
+
+//---- Pinos dos dois eixos, todos diferentes (no stm32f_stpdrv.h de exemplo há pinos repetidos)
+#define M1_STEP_PORT		GPIOE
+#define M1_STEP_PIN		GPIO_Pin_9
+#define M1_DIR_PORT		GPIOE
+#define M1_DIR_PIN		GPIO_Pin_10
+#define M2_STEP_PORT		GPIOE
+#define M2_STEP_PIN		GPIO_Pin_11
+#define M2_DIR_PORT		GPIOE
+#define M2_DIR_PIN		GPIO_Pin_12
+
+typedef StepperAxis<StpTim<1>, 1, StpPin<4, M1_STEP_PIN>, StpPin<4, M1_DIR_PIN> > Axis1;
+typedef StepperAxis<StpTim<1>, 2, StpPin<4, M2_STEP_PIN>, StpPin<4, M2_DIR_PIN> > Axis2;
+typedef StpAxes<Axis1, Axis2> Axes;
+
+static StpAxisState 	State[2];		// estado da versão com macros
+
+//==============================================================================
+//	descri:   Inversão do DIR da versão com macros, como o __DirPendingFlip do driver
+//
+static void __attribute__((noinline)) __MacroFlip(int16_t mt)
+{
+    if (State[mt].Dir == dir_CW) {
+        if (mt == (int16_t) 0x0)
+            M1_DIR_PORT->BRR = M1_DIR_PIN;
+        else
+            M2_DIR_PORT->BRR = M2_DIR_PIN;
+        State[mt].Dir = dir_CCW;
+    } else {
+        if (mt == (int16_t) 0x0)
+            M1_DIR_PORT->BSRR = M1_DIR_PIN;
+        else
+            M2_DIR_PORT->BSRR = M2_DIR_PIN;
+        State[mt].Dir = dir_CW;
+    }
+    if (State[mt].CurDelay < STPDRV_DIRSETUP) {
+        if (mt == (int16_t) 0x0)
+            STPDRV_TIM->CCR1 += STPDRV_DIRSETUP - State[mt].CurDelay;
+        else
+            STPDRV_TIM->CCR2 += STPDRV_DIRSETUP - State[mt].CurDelay;
+    }
+    State[mt].DirPending = 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   IRQ escrita à mão, os canais do STEP do TIM3_IRQHandler
+//
+void STPAXIS_SECTION("stpaxis_macro") MacroIsr(void)
+{
+    if ((STPDRV_TIM->SR & TIM_IT_CC1) && (STPDRV_TIM->DIER & TIM_IT_CC1)) {
+        STPDRV_TIM->CCR1 += State[0].CurDelay;
+        if (M1_STEP_PORT->IDR & M1_STEP_PIN) {
+            M1_STEP_PORT->BRR = M1_STEP_PIN;
+            if (State[0].DirPending)
+                __MacroFlip(0);
+        } else {
+            M1_STEP_PORT->BSRR = M1_STEP_PIN;
+            if (State[0].Dir == dir_CW)
+                State[0].Pos++;
+            else
+                State[0].Pos--;
+        }
+        STPDRV_TIM->SR = ~TIM_IT_CC1;
+    }
+
+    if ((STPDRV_TIM->SR & TIM_IT_CC2) && (STPDRV_TIM->DIER & TIM_IT_CC2)) {
+        STPDRV_TIM->CCR2 += State[1].CurDelay;
+        if (M2_STEP_PORT->IDR & M2_STEP_PIN) {
+            M2_STEP_PORT->BRR = M2_STEP_PIN;
+            if (State[1].DirPending)
+                __MacroFlip(1);
+        } else {
+            M2_STEP_PORT->BSRR = M2_STEP_PIN;
+            if (State[1].Dir == dir_CW)
+                State[1].Pos++;
+            else
+                State[1].Pos--;
+        }
+        STPDRV_TIM->SR = ~TIM_IT_CC2;
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   IRQ com os templates
+//
+void STPAXIS_SECTION("stpaxis_axis") AxisIsr(void)
+{
+    Axes::Isr();
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   IRQ vazia, para descontar o custo do ciclo de teste
+//
+void __attribute__((noinline)) EmptyIsr(void)
+{
+    STPDRV_TIM->SR = 0;
+}
+//==============================================================================
+
+//---- Resultado de uma corrida
+typedef struct {
+    StpAxisState	State[2];
+    uint16_t		Ccr[2], Sr;
+    uint32_t		Idr;
+    double			Ns;
+} TRun;
+
+//==============================================================================
+//	descri:   Corre uma IRQ sobre uma sequência de eventos pseudo-aleatória (sempre a mesma)
+//	params:	isr - IRQ a testar
+//				st - estado dos dois eixos usado por essa IRQ
+//
+static void __Run(void (*isr)(void), StpAxisState **st, long n, TRun *r)
+{
+    GPIO_TypeDef *g = GPIOE;
+    uint32_t seed = 12345, x;
+    struct timespec t0, t1;
+    long k;
+
+    memset((void *) HostTIM, 0, sizeof(HostTIM));
+    memset(HostGPIO, 0, sizeof(HostGPIO));
+    memset((void *) st[0], 0, sizeof(StpAxisState));
+    memset((void *) st[1], 0, sizeof(StpAxisState));
+    st[0]->CurDelay = 100;
+    st[1]->CurDelay = 250;
+    Axes::Init();
+    Axis1::Start(10);
+    Axis2::Start(20);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (k = 0; k < n; k++) {
+        seed = seed * 1103515245u + 12345u;
+        x = seed >> 16;
+        STPDRV_TIM->SR.Flags = (uint16_t) (((x & 3) ? x & 3 : 3) << 1);		// CC1, CC2 ou os dois
+        if ((x & 0x3F0) == 0)
+            st[x & 1]->DirPending = 1;
+        if ((x & 0xFC00) == 0)
+            st[(x >> 1) & 1]->CurDelay = (uint16_t) (x >> 4 & 0x3FF);
+        isr();
+        // o PC não tem pinos, o BSRR e o BRR passam para o IDR
+        g->IDR = (g->IDR | (g->BSRR & 0xFFFF)) & ~g->BRR;
+        g->BSRR = g->BRR = 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    memcpy((void *) &r->State[0], (void *) st[0], sizeof(StpAxisState));
+    memcpy((void *) &r->State[1], (void *) st[1], sizeof(StpAxisState));
+    r->Ccr[0] = STPDRV_TIM->CCR1;
+    r->Ccr[1] = STPDRV_TIM->CCR2;
+    r->Sr = STPDRV_TIM->SR;
+    r->Idr = g->IDR;
+    r->Ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / (double) n;
+}
+//==============================================================================
+
+//==============================================================================
+//
+int main(int argc, char **argv)
+{
+    long n = (argc > 1) ? atol(argv[1]) : 10000000;
+    StpAxisState *ms[2] = {&State[0], &State[1]}, *as[2] = {&Axis1::State, &Axis2::State};
+    TRun rm, ra, re;
+    long szm = __stop_stpaxis_macro - __start_stpaxis_macro, sza = __stop_stpaxis_axis - __start_stpaxis_axis;
+    int mt, err = 0;
+
+    if (n <= 0) {
+        fprintf(stderr, "usage: %s [events]\n", argv[0]);
+        return 1;
+    }
+
+    __Run(EmptyIsr, ms, n, &re);
+    __Run(MacroIsr, ms, n, &rm);
+    __Run(AxisIsr, as, n, &ra);
+
+    for (mt = 0; mt < 2; mt++) {
+        printf("M%d  pos %d / %d  dir %d / %d  ccr %u / %u\n", mt + 1, (int) rm.State[mt].Pos, (int) ra.State[mt].Pos,
+               rm.State[mt].Dir, ra.State[mt].Dir, rm.Ccr[mt], ra.Ccr[mt]);
+        if ((rm.State[mt].Pos != ra.State[mt].Pos) || (rm.State[mt].Dir != ra.State[mt].Dir) ||
+            (rm.State[mt].DirPending != ra.State[mt].DirPending) || (rm.Ccr[mt] != ra.Ccr[mt]))
+            err = 1;
+    }
+    if ((rm.Idr != ra.Idr) || (rm.Sr != ra.Sr))
+        err = 1;
+    printf("estado final %s\n", err ? "DIFERENTE" : "igual");
+
+    printf("tamanho: MacroIsr %ld bytes  AxisIsr %ld bytes%s\n", szm, sza, (sza > szm) ? "  MAIOR" : "");
+    if (sza > szm)
+        err = 1;
+
+    printf("%ld eventos, ns/evento no PC (x86): macros %.2f  templates %.2f  (ciclo de teste %.2f descontado)\n", n,
+           rm.Ns - re.Ns, ra.Ns - re.Ns, re.Ns);
+    return err;
+}
+//==============================================================================
+
+//=============================================================================
+// EOF stpaxis.cpp
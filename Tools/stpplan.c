@@ -0,0 +1,277 @@
+/*=============================================================================
+
+    @file    stpplan.c
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   Host motion-capacity planner for the STM32F Stepper Driver
+
+   This Software is released under no garanty.
+    You may use this software for personal use.
+    Use for commercial and/or profit applications is strictly prohibited.
+
+    COPYRIGHT (C) 2026 STM32StepperDriver contributors
+
+   ===================================================================
+	                    Description (in portuguese)
+   ===================================================================
+	Corre uma receita (script de movimentos) no PC com o código do driver (stm32f_stpdrv.c é
+	compilado aqui, com STPDRV_USE_SHAPER e STPDRV_USE_BANDS) e dá o tempo total, o tempo de
+	cada movimento, os eventos por segundo (média e pico) de cada canal do timer e a carga
+	prevista da IRQ do driver.
+
+	Compilar:	gcc -std=c99 -O2 -Ihost -o stpplan stpplan.c -lm
+
+	Usar:		stpplan [-c clock] [-e ciclos] [-t segundos] [-q] receita ...
+
+		-c clock		frequência do CPU em Hz (SystemCoreClock), por defeito 24000000
+		-e ciclos	ciclos do CPU por evento da IRQ (entrada, canal e saída), por defeito 150
+		-t segundos	tempo maximo de uma espera, por defeito 3600
+		-q				uma linha por receita: nome, tempo total (s), carga media e de pico (%)
+
+	O tempo não é simulado tick a tick, salta de compare em compare (host/hostsim.h) e em cada
+	compare corre a STPDRV_TIM_IRQHandler do driver, os passos e a posição são os do firmware.
+
+	Receita, um comando por linha (motor = 1 ou 2, # começa um comentário):
+		ramp <motor> <steps/sec/sec>						STPDRV_SetRamp(...)
+		shaper <motor> <none|zv|zvd> <freq> <damping>	STPDRV_SetShaper(...)
+		band <motor> <band> <low> <high> <slopmul>		STPDRV_SetBand(...)
+		pos <motor> <posição>								STPDRV_SetPos(...)
+		move <motor> <cw|ccw> <speed>						STPDRV_Move(...)
+		stop <motor> [hard]									STPDRV_Stop(...)
+		wait <ms>												espera um tempo
+		at <motor> <posição>									espera que o motor chegue à posição
+		idle <motor>											espera que o motor pare
+
+	Cada espera (wait, at, idle) fecha um movimento, o relatório dá o tempo e os eventos de cada
+	um. O pico de eventos é a soma das frequências de todos os canais activos no mesmo instante.
+
+==============================================================================*/
+#define STPDRV_USE_SHAPER
+#define STPDRV_USE_BANDS
+#include "../Source/stm32f_stpdrv.h"
+#undef MOTOR1_DIR_PIN
+#define MOTOR1_DIR_PIN			GPIO_Pin_10		// no exemplo o DIR é o pino do STEP
+#undef MOTOR2_DIR_PIN
+#define MOTOR2_DIR_PIN			GPIO_Pin_12
+#include "../Source/stm32f_stpdrv.c"
+#include "host/hostsim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+TIM_TypeDef 	HostTIM[4];
+GPIO_TypeDef 	HostGPIO[6];
+uint32_t 		SystemCoreClock = 24000000;
+
+#define TICKS				SIM_TICKS
+#define WAIT_TIME			0
+#define WAIT_POS			1
+#define WAIT_IDLE			2
+
+static const char *Chans[4] = {"CC1 M1 step", "CC2 M2 step", "CC3 M1 ramp", "CC4 M2 ramp"};
+
+static double 		Clock = 24000000.0;
+static double 		Cycles = 150.0;
+static uint64_t 	MaxTicks = (uint64_t) 3600 * TICKS;
+
+static uint32_t 	MinPeriod[4];	// menor intervalo entre eventos de cada canal
+static double 		PeakRate;		// soma das frequências dos canais activos, maximo
+
+//==============================================================================
+//	descri:   Actualiza o pico de eventos depois de correr código do driver
+//
+static void __Stats(void)
+{
+    uint32_t p;
+    double rate = 0;
+    int c;
+
+    for (c = 0; c < 4; c++) {
+        if (!(SimArmed & (TIM_IT_CC1 << c)))
+            continue;
+        p = (c < 2) ? Motors[c].CurDelay : Motors[c - 2].RampDelay;
+        if (p < MinPeriod[c])
+            MinPeriod[c] = p;
+        rate += (double) TICKS / (double) p;
+    }
+    if (rate > PeakRate)
+        PeakRate = rate;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Espera uma condição, a posição conta como atingida se for passada
+//	return:	0 se OK, -1 se a condição nunca for atingida
+//
+static int __Wait(int kind, uint64_t until, int mt, int32_t pos)
+{
+    uint64_t limit = SimNow + MaxTicks;
+    int32_t r, d;
+
+    if ((kind == WAIT_TIME) && (until < limit))
+        limit = until;
+    r = pos - Motors[mt].Pos;
+    for (;;) {
+        d = pos - Motors[mt].Pos;
+        if ((kind == WAIT_POS) && ((d == 0) || ((r > 0) && (d < 0)) || ((r < 0) && (d > 0))))
+            return 0;
+        if ((kind != WAIT_TIME) && !(STPDRV_TIM->DIER & (TIM_IT_CC1 << mt)))
+            return (kind == WAIT_IDLE) ? 0 : -1;
+        if ((kind != WAIT_TIME) && !(STPDRV_TIM->DIER & (TIM_IT_CC3 | TIM_IT_CC4))) {
+            // rampas paradas, o motor não pára nem muda de sentido sem um comando
+            if (kind == WAIT_IDLE)
+                return -1;
+            if ((Motors[mt].Dir == dir_CW) ? (pos < Motors[mt].Pos) : (pos > Motors[mt].Pos))
+                return -1;
+        }
+        if (SIM_Event(limit) < 0)
+            return (kind == WAIT_TIME) ? 0 : -1;
+        __Stats();
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Corre uma receita
+//	return:	0 se OK
+//
+static int __Recipe(const char *name, int quiet)
+{
+    FILE *f;
+    char line[256], cmd[16], a1[16];
+    long v[5];
+    uint64_t t0 = 0, ev0 = 0, total;
+    int n = 0, mt, k, err = 0, moves = 0, c;
+    double avg, load, peak;
+
+    if ((f = fopen(name, "r")) == NULL) {
+        perror(name);
+        return 1;
+    }
+
+    memset(Motors, 0, sizeof(Motors));
+    memset(Shapers, 0, sizeof(Shapers));
+    memset(Bands, 0, sizeof(Bands));
+    for (c = 0; c < 4; c++)
+        MinPeriod[c] = 0xFFFFFFFF;
+    PeakRate = 0;
+    SIM_Reset();
+    STPDRV_Init();
+    SIM_Sync();
+
+    if (!quiet)
+        printf("\n---- %s\n%5s %12s %12s %10s\n", name, "linha", "inicio(s)", "duracao(s)", "eventos");
+
+    while (!err && fgets(line, sizeof(line), f)) {
+        n++;
+        if (strchr(line, '#'))
+            *strchr(line, '#') = 0;
+        a1[0] = 0;
+        memset(v, 0, sizeof(v));
+        k = sscanf(line, "%15s %ld %15s", cmd, &v[0], a1);
+        if (k <= 0)
+            continue;
+        mt = (int) v[0] - 1;
+
+        if (!strcmp(cmd, "wait") && (k >= 2))
+            err = __Wait(WAIT_TIME, SimNow + (uint64_t) v[0] * (TICKS / 1000), 0, 0);
+        else if ((mt < 0) || (mt > 1) || (k < 2))
+            err = 2;
+        else if (!strcmp(cmd, "at") && (sscanf(line, "%*s %*d %ld", &v[1]) == 1))
+            err = __Wait(WAIT_POS, 0, mt, (int32_t) v[1]);
+        else if (!strcmp(cmd, "idle"))
+            err = __Wait(WAIT_IDLE, 0, mt, 0);
+        else {
+            if (!strcmp(cmd, "ramp") && (sscanf(line, "%*s %*d %ld", &v[1]) == 1))
+                STPDRV_SetRamp(mt, (int16_t) v[1]);
+            else if (!strcmp(cmd, "pos") && (sscanf(line, "%*s %*d %ld", &v[1]) == 1))
+                STPDRV_SetPos(mt, (int32_t) v[1]);
+            else if (!strcmp(cmd, "move") && (sscanf(line, "%*s %*d %*s %ld", &v[1]) == 1) &&
+                     (!strcmp(a1, "cw") || !strcmp(a1, "ccw")))
+                STPDRV_Move(mt, strcmp(a1, "cw") ? dir_CCW : dir_CW, (int16_t) v[1]);
+            else if (!strcmp(cmd, "stop"))
+                STPDRV_Stop(mt, !strcmp(a1, "hard"));
+            else if (!strcmp(cmd, "shaper") && (sscanf(line, "%*s %*d %*s %ld %ld", &v[1], &v[2]) == 2) &&
+                     (!strcmp(a1, "none") || !strcmp(a1, "zv") || !strcmp(a1, "zvd")))
+                STPDRV_SetShaper(mt, !strcmp(a1, "none") ? shaper_None : (!strcmp(a1, "zv") ? shaper_ZV : shaper_ZVD),
+                                 (uint16_t) v[1], (uint16_t) v[2]);
+            else if (!strcmp(cmd, "band") && (sscanf(line, "%*s %*d %ld %ld %ld %ld", &v[1], &v[2], &v[3], &v[4]) == 4))
+                STPDRV_SetBand(mt, (int16_t) v[1], (uint16_t) v[2], (uint16_t) v[3], (uint16_t) v[4]);
+            else
+                err = 2;
+            SIM_Sync();
+            __Stats();
+            continue;
+        }
+        if (err)
+            break;
+
+        // fim de um movimento
+        moves++;
+        if (!quiet)
+            printf("%5d %12.6f %12.6f %10llu\n", n, (double) t0 / TICKS, (double) (SimNow - t0) / TICKS,
+                   (unsigned long long) (SimEvents[0] + SimEvents[1] + SimEvents[2] + SimEvents[3] - ev0));
+        t0 = SimNow;
+        ev0 = SimEvents[0] + SimEvents[1] + SimEvents[2] + SimEvents[3];
+    }
+    fclose(f);
+
+    if (err) {
+        fprintf(stderr, "%s:%d: %s\n", name, n, err == 2 ? "comando inválido" : "condição nunca atingida");
+        return 1;
+    }
+
+    total = SimEvents[0] + SimEvents[1] + SimEvents[2] + SimEvents[3];
+    avg = SimNow ? (double) total * TICKS / (double) SimNow : 0;
+    load = avg * Cycles * 100.0 / Clock;
+    peak = PeakRate * Cycles * 100.0 / Clock;
+    if (quiet) {
+        printf("%s %.6f %.2f %.2f\n", name, (double) SimNow / TICKS, load, peak);
+        return 0;
+    }
+    printf("\n%d movimentos, tempo total %.6f s\n\n%-12s %10s %12s %12s\n", moves, (double) SimNow / TICKS,
+           "canal", "eventos", "media(ev/s)", "pico(ev/s)");
+    for (c = 0; c < 4; c++)
+        printf("%-12s %10llu %12.1f %12.1f\n", Chans[c], (unsigned long long) SimEvents[c],
+               SimNow ? (double) SimEvents[c] * TICKS / (double) SimNow : 0,
+               MinPeriod[c] != 0xFFFFFFFF ? (double) TICKS / MinPeriod[c] : 0);
+    printf("%-12s %10llu %12.1f %12.1f\n", "TIM3", (unsigned long long) total, avg, PeakRate);
+    printf("\ncarga da IRQ (%.0f ciclos/evento a %.0f Hz): media %.2f%%, pico %.2f%%\n", Cycles, Clock, load, peak);
+    if (peak >= 100.0)
+        printf("AVISO: no pico a IRQ não acompanha os eventos, os STEPs vão atrasar\n");
+    return 0;
+}
+//==============================================================================
+
+//==============================================================================
+//
+int main(int argc, char **argv)
+{
+    int a, quiet = 0, ret = 0;
+
+    for (a = 1; (a < argc) && (argv[a][0] == '-'); a++) {
+        if (!strcmp(argv[a], "-q"))
+            quiet = 1;
+        else if (!strcmp(argv[a], "-c") && (a + 1 < argc))
+            Clock = atof(argv[++a]);
+        else if (!strcmp(argv[a], "-e") && (a + 1 < argc))
+            Cycles = atof(argv[++a]);
+        else if (!strcmp(argv[a], "-t") && (a + 1 < argc))
+            MaxTicks = (uint64_t) (atof(argv[++a]) * TICKS);
+        else
+            break;
+    }
+    if ((a >= argc) || (Clock <= 0) || (Cycles <= 0)) {
+        fprintf(stderr, "usage: %s [-c clock] [-e cycles] [-t seconds] [-q] recipe ...\n", argv[0]);
+        return 1;
+    }
+    for (; a < argc; a++)
+        ret |= __Recipe(argv[a], quiet);
+    return ret;
+}
+//==============================================================================
+
+//=============================================================================
+// EOF stpplan.c
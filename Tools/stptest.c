@@ -0,0 +1,1396 @@
+/*=============================================================================
+
+    @file    stptest.c
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   Host regression tests of the STM32F Stepper Driver
+
+   This Software is released under no garanty.
+    You may use this software for personal use.
+    Use for commercial and/or profit applications is strictly prohibited.
+
+    COPYRIGHT (C) 2026 STM32StepperDriver contributors
+
+   ===================================================================
+	                    Description (in portuguese)
+   ===================================================================
+	Testes de regressão do stm32f_stpdrv.c no PC. O driver é compilado aqui com as opções que
+	não precisam de outros periféricos e corre sobre o timer simulado de host/hostsim.h: cada
+	compare chama a IRQ do driver (STPDRV_TIM_IRQHandler) e os STEPs são lidos nos pinos.
+
+	O protocolo (stm32f_stpcom.c) também é compilado aqui. O DMA RX é simulado a escrever no
+	buffer circular e a descontar o CNDTR, com a IRQ do fim da volta corrida logo ou deixada
+	pendente, e o DMA TX a copiar cada transferência para um buffer onde as respostas são lidas
+	e o CRC verificado com um CRC16 calculado bit a bit. A telemetria (stm32f_stptlm.c) corre
+	sobre o mesmo protocolo, com a IRQ da amostragem chamada directamente. O trace é pedido com o
+	STPCOM_CMD_TRACE e descodificado pelo Tools/stptrace.c (incluido sem o main), o CYCCNT
+	simulado anda com o timer.
+
+	No homing (stm32f_stphome.c) os interruptores são simulados a partir da posição contada nos
+	pinos STEP: no flanco de fecho o pino do STPHOME_PORT vai a 0, o bit do EXTI->PR é posto e a
+	EXTI15_10_IRQHandler é chamada logo, o STPHOME_Poll corre a cada 5 ms.
+
+	O scheduler (stm32f_stpsch.c) é testado sem o ciclo infinito do STPSCH_Run: o teste muda o
+	Ticks e faz as passagens pela tabela. Para o STPSCH_Micros o SysTick é simulado ciclo a ciclo,
+	com a IRQ do SysTick atrasada nos primeiros ciclos depois de cada reload (PENDSTSET ligado e
+	o Ticks ainda com o milisegundo anterior), como dentro de uma IRQ de prioridade maior.
+
+	Compilar:	gcc -std=c99 -O2 -Ihost -o stptest stptest.c -lm
+
+	Usar:		stptest [teste ...]
+
+	Sem argumentos corre todos os testes. Uma linha por teste, o programa sai com 1 se algum
+	falhar.
+
+==============================================================================*/
+#define STPDRV_USE_SHAPER
+#define STPDRV_USE_BANDS
+#define STPDRV_USE_ARC
+#define STPDRV_USE_TRACE
+#define STPDRV_USE_ENCODER
+#define STPDRV_USE_RECORD
+#define STPDRV_USE_MICROSTEP
+#define STPDRV_USE_HOMING
+#include "../Source/stm32f_stpdrv.h"
+#undef MOTOR1_DIR_PIN
+#define MOTOR1_DIR_PIN			GPIO_Pin_10		// no exemplo o DIR é o pino do STEP
+#undef MOTOR2_DIR_PIN
+#define MOTOR2_DIR_PIN			GPIO_Pin_12
+#include "../Source/stm32f_stpdrv.c"
+#include "../Source/stm32f_stpcom.c"
+#include "../Source/stm32f_stptlm.c"
+#include "../Source/stm32f_stpsch.c"
+#include "../Source/stm32f_stphome.c"
+#include "host/hostsim.h"
+#define STPTRACE_NOMAIN
+#include "stptrace.c"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+TIM_TypeDef 	HostTIM[4];
+GPIO_TypeDef 	HostGPIO[6];
+uint32_t 		SystemCoreClock = 24000000;
+uint32_t 		HostDWT[3];
+USART_TypeDef 	HostUSART[1];
+DMA_TypeDef 		HostDMA[1];
+DMA_Channel_TypeDef HostDMACh[7];
+EXTI_TypeDef 	HostEXTI;
+SysTick_Type 	HostSysTick;
+SCB_Type 			HostSCB;
+
+#define CHECK(c)	do { if (!(c)) { printf("  linha %d: %s\n", __LINE__, #c); return 1; } } while (0)
+#define NEAR(v, sp)	((v) * 100 >= (sp) * 99 && (v) * 100 <= (sp) * 101)		// CurDelay inteiro, 1%
+#define SECS(s)		((uint64_t) ((s) * SIM_TICKS))
+#define LOG_LEN		8192
+
+//---- Flancos ascendentes do STEP vistos nos pinos
+typedef struct {
+    uint32_t		Dt;				// ticks desde o flanco anterior (ou desde o __Begin)
+    uint8_t		Dir;
+    uint8_t		Mul;			// microsteps deste STEP
+} TRise;
+
+static TRise 		Log[2][LOG_LEN];
+static uint32_t 	Rises[2];			// flancos ascendentes
+static int32_t 	Net[2];				// flancos ascendentes com sinal, tem de ser igual a Pos
+static uint64_t 	LastRise[2];
+
+//==============================================================================
+//	descri:   Driver e timer no estado do reset
+//
+static void __Begin(void)
+{
+    memset(Motors, 0, sizeof(Motors));
+    memset(Bands, 0, sizeof(Bands));
+    memset(Shapers, 0, sizeof(Shapers));
+    memset(Micros, 0, sizeof(Micros));
+    memset(Recs, 0, sizeof(Recs));
+    memset(&Arc, 0, sizeof(Arc));
+    memset(Rises, 0, sizeof(Rises));
+    memset(Net, 0, sizeof(Net));
+    SIM_Reset();
+    STPDRV_Init();
+    SIM_Sync();
+    LastRise[0] = LastRise[1] = SimNow;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Nivel do pino STEP de um motor
+//
+static int __StepPin(int mt)
+{
+    return mt ? (MOTOR2_STEP_PORT->IDR & MOTOR2_STEP_PIN) != 0 : (MOTOR1_STEP_PORT->IDR & MOTOR1_STEP_PIN) != 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Condições de paragem do __Run
+//
+static int __Idle0(void)
+{
+    return !(STPDRV_TIM->DIER & TIM_IT_CC1);
+}
+//
+static int __Ramp0(void)
+{
+    return !(STPDRV_TIM->DIER & TIM_IT_CC3);
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Corre o timer até "done" (ou durante "secs" segundos se done for ZERO) e regista
+//				 os flancos ascendentes dos STEP
+//	return:	0 se OK, -1 se "done" não foi atingido em "secs" segundos
+//
+static int __Run(double secs, int (*done)(void))
+{
+    uint64_t limit = SimNow + SECS(secs);
+    int lv[2], mt;
+
+    while (!(done && done())) {
+        lv[0] = __StepPin(0);
+        lv[1] = __StepPin(1);
+        if (SIM_Event(limit) < 0)
+            return done ? -1 : 0;
+        for (mt = 0; mt < 2; mt++) {
+            if (lv[mt] || !__StepPin(mt))
+                continue;
+            if (Rises[mt] < LOG_LEN) {
+                Log[mt][Rises[mt]].Dt = (uint32_t) (SimNow - LastRise[mt]);
+                Log[mt][Rises[mt]].Dir = (uint8_t) Motors[mt].Dir;
+                Log[mt][Rises[mt]].Mul = (uint8_t) MS_MUL(mt);
+            }
+            Rises[mt]++;
+            Net[mt] += (Motors[mt].Dir == dir_CW) ? MS_MUL(mt) : -MS_MUL(mt);
+            LastRise[mt] = SimNow;
+        }
+    }
+    return 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Rampa, cruzeiro, inversão e paragem com desaceleração
+//
+static int __TestRamp(void)
+{
+    uint32_t k, up = 0;
+    uint64_t t0;
+
+    __Begin();
+    STPDRV_SetRamp(0, 2000);
+    STPDRV_Move(0, dir_CW, 800);
+    SIM_Sync();
+    t0 = SimNow;
+    CHECK(__Run(2, __Ramp0) == 0);
+    // de 50 a 800 steps/s a 2000 steps/s/s são 0.375 segundos
+    CHECK((SimNow - t0 > SECS(0.3)) && (SimNow - t0 < SECS(0.45)));
+    CHECK(STPDRV_GetSpeed(0) == 800);
+    CHECK(STPDRV_GetState(0) == mstat_Move);
+    for (k = 2; k < Rises[0]; k++)
+        up += (Log[0][k].Dt > Log[0][k - 1].Dt);		// a acelerar o periodo nunca aumenta
+    CHECK(up == 0);
+
+    CHECK(__Run(0.5, 0) == 0);
+    STPDRV_Move(0, dir_CCW, 600);
+    SIM_Sync();
+    CHECK(__Run(2, __Ramp0) == 0);
+    CHECK((STPDRV_GetDir(0) == dir_CCW) && NEAR(STPDRV_GetSpeed(0), 600));
+    // na inversão o ultimo STEP no sentido antigo e o primeiro no novo são à velocidade de arranque
+    for (k = 1; (k < Rises[0]) && (Log[0][k].Dir == dir_CW); k++)
+        ;
+    CHECK((k < Rises[0]) && (Log[0][k].Dt >= SIM_TICKS / STPDRV_STARTSTOPSEC - 4));
+
+    STPDRV_Stop(0, 0);
+    SIM_Sync();
+    CHECK(__Run(2, __Idle0) == 0);
+    CHECK(STPDRV_GetState(0) == mstat_Stop);
+    CHECK(STPDRV_GetPos(0) == Net[0]);
+    return 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Bandas de ressonância: cruzeiro fora da banda e travessia com aceleração maior
+//
+static int __TestBand(void)
+{
+    uint64_t in = 0;
+    uint32_t k, sp;
+
+    __Begin();
+    STPDRV_SetRamp(0, 2000);
+    CHECK(STPDRV_SetBand(0, 0, 40, 60, 1) == 0);		// contém a velocidade de arranque/paragem
+    CHECK(STPDRV_SetBand(0, 0, STPDRV_STARTSTOPSEC, 60, 1) == 1);		// como limite pode
+    CHECK(STPDRV_SetBand(0, 0, 300, 500, 4) == 1);
+    CHECK(STPDRV_SetBand(0, 1, 450, 700, 2) == 0);		// sobreposta
+    STPDRV_Move(0, dir_CW, 400);
+    SIM_Sync();
+    CHECK(__Run(2, __Ramp0) == 0);
+    CHECK(STPDRV_GetSpeed(0) == 300);		// no meio da banda fica no limite inferior
+
+    k = Rises[0];
+    STPDRV_Move(0, dir_CW, 800);
+    SIM_Sync();
+    CHECK(__Run(2, __Ramp0) == 0);
+    CHECK(STPDRV_GetSpeed(0) == 800);
+    for (; k < Rises[0]; k++) {
+        sp = (uint32_t) (SIM_TICKS / Log[0][k].Dt);
+        if ((sp > 310) && (sp < 490))
+            in += Log[0][k].Dt;
+    }
+    // 200 steps/s dentro da banda a 4 x 2000 steps/s/s são 25ms, sem a banda seriam 100ms
+    CHECK((in > 0) && (in < SECS(0.04)));
+
+    STPDRV_Move(0, dir_CW, 450);
+    SIM_Sync();
+    CHECK(__Run(2, __Ramp0) == 0);
+    CHECK(STPDRV_GetSpeed(0) == 500);		// mais perto do limite superior
+
+    STPDRV_Stop(0, 0);
+    SIM_Sync();
+    CHECK(__Run(2, __Idle0) == 0);
+    CHECK(STPDRV_GetPos(0) == Net[0]);
+    return 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Banda com um slope maior que o limite inferior: é recusada e, posta à força, a
+//				 desaceleração não passa por baixo de zero
+//
+static int __TestBandSlow(void)
+{
+    uint16_t max = 0;
+
+    __Begin();
+    STPDRV_SetRamp(0, 2000);
+    CHECK(STPDRV_SetBand(0, 0, 20, 60, 40) == 0);		// slope 2 x 40 maior que 20
+    Bands[0][0].Low = 20;
+    Bands[0][0].High = 60;
+    Bands[0][0].SlopMul = 40;
+    STPDRV_Move(0, dir_CW, 100);
+    SIM_Sync();
+    CHECK(__Run(2, __Ramp0) == 0);
+    STPDRV_Move(0, dir_CW, 10);
+    SIM_Sync();
+    while (!__Ramp0()) {
+        CHECK(__Run(0.001, 0) == 0);
+        CHECK(SimNow < SECS(5));
+        if (Motors[0].TargetCurSpeed > max)
+            max = Motors[0].TargetCurSpeed;
+    }
+    CHECK(max <= 100);
+    CHECK((STPDRV_GetSpeed(0) == 10) && (Motors[0].CurDelay == STPDRV_TIMFREQ / 10));
+    return 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Vibração residual de uma massa com mola (f = 10Hz, z = 0.01) ligada ao motor, depois
+//				 de acelerar até ao cruzeiro: x'' = -w^2 (x - u) - 2 z w x', u é a posição do motor.
+//				 O arranque a STPDRV_STARTSTOPSEC não passa pelo shaper, a massa começa a essa velocidade
+//	params:	type - shaper a usar
+//	return:	amplitude da oscilação da velocidade da massa no cruzeiro, em steps/sec
+//
+static double __Residual(mshaper_t type)
+{
+    const double w = 2 * 3.14159265358979 * 10.0, z = 0.01, dt = 2.0 / SIM_TICKS;
+    double x = 0, v = STPDRV_STARTSTOPSEC, u, a, res = 0;
+    uint64_t end = 0;
+
+    __Begin();
+    STPDRV_SetRamp(0, 4000);
+    if (STPDRV_SetShaper(0, type, 100, 10) != 1)
+        return -1;
+    STPDRV_Move(0, dir_CW, 650);		// 0.15s de rampa, um periodo e meio: o pior caso sem shaper
+    SIM_Sync();
+    while ((end == 0) || (SimNow < end)) {
+        while (SIM_Event(SimNow + 2) >= 0)
+            ;
+        if (SimNow > SECS(5))
+            return -1;
+        u = (double) Motors[0].Pos;
+        a = -w * w * (x - u) - 2 * z * w * v;
+        v += a * dt;
+        x += v * dt;
+        if ((end == 0) && __Ramp0())
+            end = SimNow + SECS(0.3);
+        else if (end && (fabs(v - 650) > res))
+            res = fabs(v - 650);
+    }
+    return res;
+}
+//
+static int __TestShaper(void)
+{
+    double none, zv, zvd;
+
+    none = __Residual(shaper_None);
+    zv = __Residual(shaper_ZV);
+    zvd = __Residual(shaper_ZVD);
+    CHECK((none > 0) && (zv >= 0) && (zvd >= 0));
+    // sem shaper os dois saltos da aceleração somam-se, ~2 a / w = 130 steps/sec
+    CHECK(none > 60);
+    CHECK((zv < none / 4) && (zvd < none / 4));
+    return 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Coeficientes inteiros do shaper contra as formulas em vírgula flutuante, e inversão
+//				 com o shaper ligado: o sentido novo começa à velocidade de inversão sem misturar
+//				 o historico do sentido antigo
+//
+static int __TestShaperRev(void)
+{
+    static const uint16_t damp[] = {0, 10, 50, 200, 500, 900};
+    double z, k, r, ticks;
+    uint32_t d, i, up = 0;
+
+    __Begin();
+    STPDRV_SetRamp(0, 4000);
+    for (d = 0; d < sizeof(damp) / sizeof(damp[0]); d++) {
+        z = damp[d] / 1000.0;
+        k = exp(-3.14159265358979 * z / sqrt(1 - z * z));
+        r = k / (1 + k);
+        ticks = 10.0 / (2.0 * 100 * sqrt(1 - z * z)) * (STPDRV_TIMFREQ * 2) / Motors[0].RampDelay;
+        CHECK(STPDRV_SetShaper(0, shaper_ZV, 100, damp[d]) == 1);
+        CHECK(fabs(Shapers[0].A[1] - 32768 * r) < 80);
+        CHECK(abs((int) (Shapers[0].N[1] * Shapers[0].Div) - (int) (ticks + 0.5)) <= (int) Shapers[0].Div);
+        CHECK(STPDRV_SetShaper(0, shaper_ZVD, 100, damp[d]) == 1);
+        CHECK(fabs(Shapers[0].A[1] - 32768 * 2 * r * (1 - r)) < 80);
+        CHECK(fabs(Shapers[0].A[2] - 32768 * r * r) < 80);
+    }
+
+    __Begin();
+    STPDRV_SetRamp(0, 4000);
+    CHECK(STPDRV_SetShaper(0, shaper_ZVD, 100, 10) == 1);
+    STPDRV_Move(0, dir_CW, 650);
+    SIM_Sync();
+    CHECK(__Run(2, __Ramp0) == 0);
+    STPDRV_Move(0, dir_CCW, 650);
+    SIM_Sync();
+    while (Motors[0].Dir == dir_CW) {
+        CHECK(__Run(0.0001, 0) == 0);
+        CHECK(SimNow < SECS(5));
+    }
+    for (i = 0; i < STPDRV_SHAPER_LEN; i++)
+        CHECK(Shapers[0].Hist[i] <= STPDRV_STARTSTOPSEC);
+    CHECK(__Run(2, __Ramp0) == 0);
+    CHECK((STPDRV_GetDir(0) == dir_CCW) && NEAR(STPDRV_GetSpeed(0), 650));
+    for (i = 1; (i < Rises[0]) && (Log[0][i].Dir == dir_CW); i++)
+        ;
+    // o meio periodo do primeiro STEP no sentido novo é à velocidade de inversão (o intervalo também
+    // tem o ultimo meio periodo do sentido antigo, que o shaper ainda não deixou chegar lá) e depois
+    // só acelera
+    CHECK((i < Rises[0]) && (Log[0][i].Dt >= SIM_TICKS / STPDRV_STARTSTOPSEC * 9 / 10));
+    for (i += 2; i < Rises[0]; i++)
+        up += (Log[0][i].Dt > Log[0][i - 1].Dt + 1);
+    CHECK(up == 0);
+    return 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Microstepping automático: a velocidade em microsteps/sec é continua nas mudanças
+//				 de resolução, a subir e a descer
+//
+static int __TestMicro(void)
+{
+    uint32_t k, sw = 0;
+    double v, p = 0, jump = 0;
+
+    __Begin();
+    STPDRV_SetRamp(0, 20000);
+    CHECK(STPDRV_SetMicrostep(0, 1, 4, GPIO_Pin_1, 900, 700) == 1);		// como no main.c
+    CHECK(STPDRV_SetMicrostep(0, 2, 16, 0, 3000, 2400) == 1);
+    STPDRV_Move(0, dir_CW, 4000);
+    SIM_Sync();
+    CHECK(__Run(2, __Ramp0) == 0);
+    CHECK(MS_MUL(0) == 16);
+    CHECK(__Run(0.05, 0) == 0);
+    STPDRV_Move(0, dir_CW, 400);
+    SIM_Sync();
+    CHECK(__Run(2, __Ramp0) == 0);
+    CHECK(MS_MUL(0) == 1);
+    CHECK(Rises[0] < LOG_LEN);
+
+    // um intervalo tem meio periodo de cada STEP, com a resolução de cada um
+    for (k = 1; k < Rises[0]; k++) {
+        v = (Log[0][k - 1].Mul + Log[0][k].Mul) * (double) SIM_TICKS / (2.0 * Log[0][k].Dt);
+        if (k > 1) {
+            if ((Log[0][k].Mul != Log[0][k - 1].Mul) || (Log[0][k - 1].Mul != Log[0][k - 2].Mul)) {
+                if (fabs(v / p - 1) > jump)
+                    jump = fabs(v / p - 1);		// intervalos com o meio periodo da mudança
+            }
+            sw += (Log[0][k].Mul != Log[0][k - 1].Mul);
+        }
+        p = v;
+    }
+    CHECK(sw == 4);
+    // a 20000 steps/s/s a velocidade muda até ~12% por STEP perto das 700 steps/s, sem a
+    // correção do compare o primeiro STEP depois da mudança saía ao dobro ou a metade
+    CHECK(jump < 0.25);
+
+    STPDRV_Stop(0, 0);
+    SIM_Sync();
+    CHECK(__Run(2, __Idle0) == 0);
+    CHECK(STPDRV_GetPos(0) == Net[0]);
+    return 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Correcção do encoder: os STEPs extra saem mesmo (mais flancos que sem correcção),
+//				 a posição e o timing dos STEPs normais não mudam
+//	params:	inject - STEPs de correcção
+//          rises - flancos ascendentes no fim
+//	return:	posição no fim, ou INT32_MIN se falhar
+//
+static int32_t __InjectRun(uint16_t inject, uint32_t *rises)
+{
+    __Begin();
+    STPDRV_SetRamp(0, 2000);
+    STPDRV_Move(0, dir_CW, 400);
+    SIM_Sync();
+    if (__Run(2, __Ramp0) != 0)
+        return INT32_MIN;
+    STPDRV_Inject(0, inject);
+    if (__Run(0.5, 0) != 0)
+        return INT32_MIN;
+    *rises = Rises[0];
+    return STPDRV_GetPos(0);
+}
+//
+static int __TestInject(void)
+{
+    uint32_t r0, r1, k, n;
+    int32_t p0, p1;
+
+    p0 = __InjectRun(0, &r0);
+    p1 = __InjectRun(10, &r1);
+    CHECK((p0 != INT32_MIN) && (p1 != INT32_MIN));
+    CHECK(r1 == r0 + 10);			// 10 STEPs extra emitidos em 0.5s
+    CHECK(p1 == p0);				// que não contam na posição
+    CHECK(Net[0] == p1 + 10);
+    CHECK(Motors[0].Inject == 0);
+    // nenhum intervalo abaixo de metade do periodo do cruzeiro
+    for (k = n = 0; k < Rises[0]; k++)
+        n += (Log[0][k].Dt < SIM_TICKS / 400 / 2 - 2);
+    CHECK(n == 0);
+
+    // a correcção pendente é anulada na paragem
+    STPDRV_Inject(0, 1000);
+    STPDRV_Stop(0, 0);
+    SIM_Sync();
+    CHECK(__Run(2, __Idle0) == 0);
+    CHECK((Motors[0].Inject == 0) && (Motors[0].InjHalf == 0));
+    return 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Arco de 90 graus e volta completa, os STEPs ficam a menos de um passo do circulo
+//
+static int __TestArc(void)
+{
+    int64_t r2 = 200 * 200, d, v2;
+    int32_t x, y, v;
+    mstatus_t st;
+    int max = 0;
+
+    __Begin();
+    STPDRV_SetRamp(0, 4000);
+    STPDRV_SetPos(0, 200);
+    STPDRV_SetPos(1, 0);
+    CHECK(STPDRV_Arc(0, 0, 0, 200, dir_CCW, 500) == 1);
+    SIM_Sync();
+    while (!__Idle0()) {
+        CHECK(__Run(0.001, 0) == 0);
+        CHECK(SimNow < SECS(5));
+        x = STPDRV_GetPos(0);
+        y = STPDRV_GetPos(1);
+        d = (int64_t) x * x + (int64_t) y * y - r2;
+        d = d < 0 ? -d : d;
+        if (d > max)
+            max = (int) d;
+        if (!Arc.Active)
+            continue;
+        // cada eixo dá a sua velocidade, a soma dos quadrados é a tangencial (1%, o ponto pode estar
+        // até um step fora do circulo)
+        v = (int32_t) CUR_SPEED(0);
+        v2 = (int64_t) STPDRV_GetSpeed(0) * STPDRV_GetSpeed(0) + (int64_t) STPDRV_GetSpeed(1) * STPDRV_GetSpeed(1);
+        CHECK((v2 * 10000 <= (int64_t) v * v * 10201) && (v2 * 10000 >= (int64_t) v * v * 9801));
+        CHECK((abs(x) <= abs(y) + 2) || (STPDRV_GetSpeed(1) >= STPDRV_GetSpeed(0)));
+        STPDRV_GetStatus(1, &st);
+        CHECK((st.State == mstat_Arc) && (st.RampSpeed == STPDRV_GetSpeed(1)));
+    }
+    CHECK((STPDRV_GetPos(0) == 0) && (STPDRV_GetPos(1) == 200));
+    CHECK(max <= 2 * 200 + 1);
+    CHECK((STPDRV_GetState(0) == mstat_Stop) && (STPDRV_GetState(1) == mstat_Stop));
+    CHECK((STPDRV_GetPos(0) - 200 == Net[0]) && (STPDRV_GetPos(1) == Net[1]));
+
+    // ponto final igual ao inicial, volta completa
+    CHECK(STPDRV_Arc(0, 0, 0, 200, dir_CW, 500) == 1);
+    SIM_Sync();
+    CHECK(__Run(10, __Idle0) == 0);
+    CHECK((STPDRV_GetPos(0) == 0) && (STPDRV_GetPos(1) == 200));
+    CHECK(Rises[1] > 4 * 200);
+    return 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Gravação com inversão e reprodução: os mesmos STEPs com o mesmo timing
+//
+static int __TestRecord(void)
+{
+    static TRise rec[LOG_LEN];
+    static uint8_t buf[1024];
+    uint32_t n, k;
+    uint16_t len;
+    int32_t d;
+
+    __Begin();
+    STPDRV_SetRamp(0, 2000);
+    CHECK(STPDRV_RecStart(0, buf, sizeof(buf)) == 1);
+    STPDRV_Move(0, dir_CW, 600);
+    SIM_Sync();
+    CHECK(__Run(0.5, 0) == 0);
+    STPDRV_Move(0, dir_CCW, 400);
+    SIM_Sync();
+    CHECK(__Run(0.8, 0) == 0);
+    STPDRV_Stop(0, 0);
+    SIM_Sync();
+    CHECK(__Run(2, __Idle0) == 0);
+    len = STPDRV_RecEnd(0);
+    CHECK((len > 0) && (len < sizeof(buf)) && (Rises[0] < LOG_LEN));
+    n = Rises[0];
+    d = STPDRV_GetPos(0);
+    memcpy(rec, Log[0], n * sizeof(TRise));
+
+    // a reprodução começa com o STEP em baixo e os intervalos contam a partir do Replay
+    CHECK(__Run(0.1, 0) == 0);
+    STPDRV_SetPos(0, 1000);
+    Rises[0] = 0;
+    LastRise[0] = SimNow;
+    CHECK(STPDRV_Replay(0, buf, len) == 1);
+    SIM_Sync();
+    CHECK(__Run(5, __Idle0) == 0);
+    CHECK(Rises[0] == n);
+    for (k = 0; k < n; k++)
+        CHECK((rec[k].Dt == Log[0][k].Dt) && (rec[k].Dir == Log[0][k].Dir));
+    CHECK(STPDRV_GetPos(0) == 1000 + d);
+    CHECK(STPDRV_GetState(0) == mstat_Stop);
+    return 0;
+}
+//==============================================================================
+
+//---- USART e DMA simulados do protocolo
+static uint8_t 	ComOut[8192];		// bytes enviados pelo DMA TX
+static uint32_t 	ComOutLen;
+static uint32_t 	ComOutRd;
+
+//==============================================================================
+//	descri:   Aplica o IFCR ao ISR do DMA (no chip é imediato), chamar depois de cada IRQ do DMA
+//
+static void __DmaIfcr(void)
+{
+    uint32_t f = DMA1->IFCR, b;
+
+    for (b = 0; b < 28; b += 4)
+        if (f & (1u << b))
+            f |= 0xFu << b;		// o CGIFx apaga as 4 flags do canal
+    DMA1->ISR &= ~f;
+    DMA1->IFCR = 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   IRQ do fim de volta do DMA RX, se estiver pendente
+//
+static void __ComRxIrq(void)
+{
+    if (DMA1->ISR & STPCOM_DMA_RX_TC) {
+        DMA1_Channel5_IRQHandler();
+        __DmaIfcr();
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Bytes recebidos pela USART, escritos pelo DMA RX no buffer circular. No fim da volta
+//				 o CNDTR é recarregado e a flag de transfer complete posta
+//	params:	irq - 1 corre a IRQ logo, 0 deixa-a pendente (ver __ComRxIrq)
+//
+static void __ComRx(const uint8_t *b, uint32_t n, int irq)
+{
+    while (n--) {
+        RxBuf[STPCOM_RXSIZE - STPCOM_DMA_RX->CNDTR] = *b++;
+        if (--STPCOM_DMA_RX->CNDTR == 0) {
+            STPCOM_DMA_RX->CNDTR = STPCOM_RXSIZE;
+            DMA1->ISR |= STPCOM_DMA_RX_TC;
+        }
+        if (irq)
+            __ComRxIrq();
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Esvazia o buffer de transmissão: cada transferência começada pelo __TxKick vai para
+//				 ComOut e a IRQ de fim de transferência começa a seguinte
+//
+static void __ComTx(void)
+{
+    uint32_t k;
+
+    while (STPCOM_DMA_TX->CCR & DMA_CCR1_EN) {
+        for (k = 0; k < STPCOM_DMA_TX->CNDTR; k++)
+            ComOut[ComOutLen++ & (sizeof(ComOut) - 1)] = TxBuf[TxTail + k];
+        STPCOM_DMA_TX->CNDTR = 0;
+        STPCOM_DMA_TX->CCR &= ~DMA_CCR1_EN;
+        DMA1->ISR |= STPCOM_DMA_TX_TC;
+        DMA1_Channel4_IRQHandler();
+        __DmaIfcr();
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   CRC16 CCITT bit a bit, independente da tabela do stm32f_stpcom.c
+//
+static uint16_t __Crc(const uint8_t *b, uint32_t n)
+{
+    uint16_t c = 0xFFFF;
+    int i;
+
+    while (n--) {
+        c ^= (uint16_t) (*b++ << 8);
+        for (i = 0; i < 8; i++)
+            c = (c & 0x8000) ? (uint16_t) ((c << 1) ^ 0x1021) : (uint16_t) (c << 1);
+    }
+    return c;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Monta um frame
+//	return:	numero de bytes do frame
+//
+static uint32_t __Frame(uint8_t *f, uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    uint16_t crc;
+
+    f[0] = STPCOM_SYNC;
+    f[1] = len;
+    f[2] = cmd;
+    memcpy(&f[3], payload, len);
+    crc = __Crc(&f[1], len + 2u);
+    f[len + 3] = (uint8_t) crc;
+    f[len + 4] = (uint8_t) (crc >> 8);
+    return len + 5u;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Lê a proxima resposta de ComOut e verifica o sync e o CRC
+//	params:	cmd - CMD da resposta
+//          data - payload da resposta (pode ser ZERO)
+//	return:	numero de bytes do payload, -1 se não houver resposta, -2 se o frame estiver errado
+//
+static int __ComReply(uint8_t *cmd, uint8_t *data)
+{
+    uint8_t f[STPCOM_MAXPAYLOAD + 5];
+    uint32_t n, k;
+
+    if (ComOutRd + 5 > ComOutLen)
+        return -1;
+    n = ComOut[(ComOutRd + 1) & (sizeof(ComOut) - 1)] + 5u;
+    if ((n > sizeof(f)) || (ComOutRd + n > ComOutLen))
+        return -2;
+    for (k = 0; k < n; k++)
+        f[k] = ComOut[ComOutRd++ & (sizeof(ComOut) - 1)];
+    if ((f[0] != STPCOM_SYNC) || (__Crc(&f[1], n - 3) != (uint16_t) (f[n - 2] | (f[n - 1] << 8))))
+        return -2;
+    *cmd = f[2];
+    if (data)
+        memcpy(data, &f[3], n - 5);
+    return (int) (n - 5);
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Envia um comando e devolve o estado da resposta
+//	params:	data - payload da resposta a seguir ao estado (pode ser ZERO)
+//	return:	estado (STPCOM_ACK ou STPCOM_NAK_xxx), -1 sem resposta, -2 resposta errada
+//
+static int __ComCmd(uint8_t cmd, const uint8_t *p, uint8_t len, uint8_t *data)
+{
+    uint8_t f[STPCOM_MAXPAYLOAD + 5], q[STPCOM_MAXPAYLOAD], rc;
+    int n;
+
+    __ComRx(f, __Frame(f, cmd, p, len), 1);
+    STPCOM_Poll();
+    __ComTx();
+    n = __ComReply(&rc, q);
+    if (n < 0)
+        return n;
+    if ((n < 1) || (rc != (cmd | STPCOM_REPLY)))
+        return -2;
+    if (data)
+        memcpy(data, &q[1], (size_t) n - 1);
+    return q[0];
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Driver e protocolo no estado do reset
+//
+static void __ComBegin(void)
+{
+    __Begin();
+    memset((void *) HostUSART, 0, sizeof(HostUSART));
+    memset((void *) HostDMA, 0, sizeof(HostDMA));
+    memset((void *) HostDMACh, 0, sizeof(HostDMACh));
+    memset(&Stats, 0, sizeof(Stats));
+    STPCOM_Init();
+    ComOutLen = ComOutRd = 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Protocolo: respostas e CRC de cada comando, todos os NAK, CRC errado, lixo antes
+//				 do sync e frames que chegam aos bocados
+//
+static int __TestCom(void)
+{
+    uint8_t p[8], q[STPCOM_MAXPAYLOAD], f[STPCOM_MAXPAYLOAD + 5], rc;
+    uint16_t max;
+    uint32_t n;
+
+    __ComBegin();
+    p[0] = MOTOR1;
+    CHECK(__ComCmd(STPCOM_CMD_QUERY, p, 1, q) == STPCOM_ACK);
+    CHECK((q[4] == dir_CW) && (q[5] == mstat_Stop) && (q[6] == 0) && (q[7] == 0));
+
+    // SETRAMP: rampspeed entre STPCOM_MINRAMP e 32767
+    p[1] = (uint8_t) 2000; p[2] = (uint8_t) (2000 >> 8);
+    CHECK(__ComCmd(STPCOM_CMD_SETRAMP, p, 3, 0) == STPCOM_ACK);
+    p[1] = STPCOM_MINRAMP - 1; p[2] = 0;
+    CHECK(__ComCmd(STPCOM_CMD_SETRAMP, p, 3, 0) == STPCOM_NAK_PARM);
+    p[1] = 0x00; p[2] = 0x80;
+    CHECK(__ComCmd(STPCOM_CMD_SETRAMP, p, 3, 0) == STPCOM_NAK_PARM);
+
+    // MOVE: speed entre STPDRV_MINSETPSEC e STPDRV_GetMaxSpeed, motor e dir válidos
+    max = STPDRV_GetMaxSpeed(MOTOR1);
+    p[1] = dir_CW; p[2] = (uint8_t) (max + 1); p[3] = (uint8_t) ((max + 1) >> 8);
+    CHECK(__ComCmd(STPCOM_CMD_MOVE, p, 4, 0) == STPCOM_NAK_PARM);
+    p[2] = STPDRV_MINSETPSEC - 1; p[3] = 0;
+    CHECK(__ComCmd(STPCOM_CMD_MOVE, p, 4, 0) == STPCOM_NAK_PARM);
+    p[1] = dir_ANY; p[2] = 200;
+    CHECK(__ComCmd(STPCOM_CMD_MOVE, p, 4, 0) == STPCOM_NAK_PARM);
+    p[0] = MOTOR2 + 1; p[1] = dir_CW;
+    CHECK(__ComCmd(STPCOM_CMD_MOVE, p, 4, 0) == STPCOM_NAK_PARM);
+    CHECK((STPDRV_TIM->DIER & (TIM_IT_CC1 | TIM_IT_CC2)) == 0);
+    p[0] = MOTOR1;
+    CHECK(__ComCmd(STPCOM_CMD_MOVE, p, 4, 0) == STPCOM_ACK);
+    CHECK(STPDRV_TIM->DIER & TIM_IT_CC1);
+    CHECK(__ComCmd(STPCOM_CMD_MOVE, p, 3, 0) == STPCOM_NAK_LEN);
+
+    // GOTO não suportado, com o tamanho certo
+    memset(p, 0, sizeof(p));
+    CHECK(__ComCmd(STPCOM_CMD_GOTO, p, 8, 0) == STPCOM_NAK_UNSUP);
+    CHECK(__ComCmd(STPCOM_CMD_GOTO, p, 4, 0) == STPCOM_NAK_LEN);
+    CHECK(__ComCmd(0x33, p, 1, 0) == STPCOM_NAK_CMD);
+    p[1] = 1;
+    CHECK(__ComCmd(STPCOM_CMD_STOP, p, 2, 0) == STPCOM_ACK);
+    CHECK(Stats.Frames == 14);
+
+    // CRC errado: sem resposta, o frame seguinte é interpretado
+    n = __Frame(f, STPCOM_CMD_QUERY, p, 1);
+    f[n - 1] ^= 0x01;
+    __ComRx(f, n, 1);
+    STPCOM_Poll();
+    __ComTx();
+    CHECK((__ComReply(&rc, 0) == -1) && (Stats.CrcErrors == 1));
+    // lixo e um LEN maior que STPCOM_MAXPAYLOAD antes do sync
+    f[0] = 0x00; f[1] = STPCOM_SYNC; f[2] = STPCOM_MAXPAYLOAD + 1;
+    __ComRx(f, 3, 1);
+    CHECK(__ComCmd(STPCOM_CMD_QUERY, p, 1, 0) == STPCOM_ACK);
+    CHECK(Stats.SyncErrors >= 2);
+
+    // frame aos bocados: só é interpretado quando chega o ultimo byte
+    n = __Frame(f, STPCOM_CMD_QUERY, p, 1);
+    __ComRx(f, 4, 1);
+    STPCOM_Poll();
+    __ComTx();
+    CHECK(__ComReply(&rc, 0) == -1);
+    __ComRx(&f[4], n - 4, 1);
+    STPCOM_Poll();
+    __ComTx();
+    CHECK((__ComReply(&rc, q) == 9) && (rc == (STPCOM_CMD_QUERY | STPCOM_REPLY)) && (q[0] == STPCOM_ACK));
+    CHECK((Stats.Frames == 16) && (Stats.CrcErrors == 1) && (Stats.TxDrops == 0) && (Stats.RxOverruns == 0));
+    return 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Protocolo: frames a passar o fim do buffer circular, a volta do DMA com a IRQ do
+//				 fim da volta ainda pendente (não é overrun), um overrun verdadeiro e o numero de
+//				 frames por segundo que o Poll interpreta e responde no PC
+//
+static int __TestComWrap(void)
+{
+    uint8_t p[1] = {MOTOR1}, f[STPCOM_MAXPAYLOAD + 5], rc;
+    uint32_t n, k, ok = 0;
+    clock_t t0;
+    double secs;
+
+    __ComBegin();
+    n = __Frame(f, STPCOM_CMD_QUERY, p, 1);		// 6 bytes, não divide o tamanho do buffer
+    for (k = 0; k < 1000; k++) {
+        __ComRx(f, n, 1);
+        if ((k % 3) == 2) {
+            STPCOM_Poll();
+            __ComTx();
+            while (__ComReply(&rc, 0) == 9)
+                ok++;
+        }
+    }
+    STPCOM_Poll();
+    __ComTx();
+    while (__ComReply(&rc, 0) == 9)
+        ok++;
+    CHECK((ok == 1000) && (Stats.Frames == 1000) && (Stats.RxOverruns == 0) && (Stats.CrcErrors == 0));
+
+    // um frame acaba 2 bytes depois do fim da volta e o Poll corre antes da IRQ do DMA: o CNDTR
+    // já foi recarregado mas RxLaps ainda não
+    __ComBegin();
+    for (k = 0; k < STPCOM_RXSIZE / n; k++)
+        __ComRx(f, n, 1);
+    STPCOM_Poll();
+    __ComTx();
+    ComOutRd = ComOutLen;
+    CHECK(STPCOM_RXSIZE - STPCOM_DMA_RX->CNDTR + n > STPCOM_RXSIZE);
+    __ComRx(f, n, 0);
+    CHECK((DMA1->ISR & STPCOM_DMA_RX_TC) && (RxLaps == 0));
+    STPCOM_Poll();
+    __ComTx();
+    CHECK((__ComReply(&rc, 0) == 9) && (Stats.RxOverruns == 0));
+    __ComRxIrq();
+    CHECK(RxLaps == 1);
+    STPCOM_Poll();
+    CHECK(__ComCmd(STPCOM_CMD_QUERY, p, 1, 0) == STPCOM_ACK);
+    CHECK((Stats.Frames == STPCOM_RXSIZE / n + 2) && (Stats.RxOverruns == 0));
+
+    // overrun verdadeiro: mais de uma volta sem Poll, descarta e volta a sincronizar
+    for (k = 0; k < STPCOM_RXSIZE / n + 1; k++)
+        __ComRx(f, n, 1);
+    STPCOM_Poll();
+    CHECK(Stats.RxOverruns == 1);
+    CHECK(__ComCmd(STPCOM_CMD_QUERY, p, 1, 0) == STPCOM_ACK);
+
+    // frames/s: recepção, Poll, resposta e transmissão de um QUERY
+    __ComBegin();
+    t0 = clock();
+    for (k = 0; k < 200000; k++) {
+        __ComRx(f, n, 1);
+        STPCOM_Poll();
+        __ComTx();
+    }
+    secs = (double) (clock() - t0) / CLOCKS_PER_SEC;
+    CHECK(Stats.Frames == 200000);
+    printf("  %.0f frames/s (QUERY e resposta, no PC)\n", secs > 0 ? k / secs : 0.0);
+    return 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Telemetria sobrecarregada: o buffer das amostras enche com a transmissão parada,
+//				 as amostras a mais são contadas em Dropped, as que ficaram saem por ordem e uma
+//				 resposta a um comando passa sempre (STPCOM_REPLY_ROOM)
+//
+static int __TestTlm(void)
+{
+    uint8_t p[1] = {MOTOR1}, f[STPCOM_MAXPAYLOAD + 5], q[STPCOM_MAXPAYLOAD], rc;
+    uint32_t k, n, samples = 0, replies = 0, tick0 = 0;
+    int32_t pos, last = 0;
+    uint16_t tick;
+    int len, i;
+
+    __ComBegin();
+    STPTLM_Init();
+    STPDRV_Move(MOTOR1, dir_CW, 400);
+    SIM_Sync();
+    STPTLM_Start(1000, 0x03);
+    // 100 amostragens dos dois motores sem Poll: cabem STPTLM_SIZE - 1
+    for (k = 0; k < 100; k++) {
+        STPTLM_TIM->SR |= TIM_IT_Update;
+        TIM4_IRQHandler();
+        CHECK(__Run(0.001, 0) == 0);
+    }
+    CHECK(((Head - Tail) & (STPTLM_SIZE - 1)) == STPTLM_SIZE - 1);
+    CHECK(STPTLM_GetDropped() == 200 - (STPTLM_SIZE - 1));
+
+    // com o DMA TX parado a telemetria enche o buffer de transmissão até deixar STPCOM_REPLY_ROOM,
+    // a resposta ao QUERY cabe
+    STPTLM_Poll();
+    CHECK(STPCOM_TxFree() >= STPCOM_REPLY_ROOM - 5);
+    __ComRx(f, __Frame(f, STPCOM_CMD_QUERY, p, 1), 1);
+    STPCOM_Poll();
+    CHECK(Stats.TxDrops == 0);
+
+    // esvazia tudo e lê os frames por ordem
+    for (k = 0; (k < 100) && ((Head != Tail) || (STPCOM_DMA_TX->CCR & DMA_CCR1_EN)); k++) {
+        __ComTx();
+        STPTLM_Poll();
+    }
+    CHECK(Head == Tail);
+    while ((len = __ComReply(&rc, q)) >= 0) {
+        if (rc == (STPCOM_CMD_QUERY | STPCOM_REPLY)) {
+            CHECK((len == 9) && (q[0] == STPCOM_ACK));
+            replies++;
+            continue;
+        }
+        CHECK((rc == STPCOM_TLM_SAMPLES) && (len >= 2 + 11) && (((len - 2) % 11) == 0));
+        CHECK((uint16_t) (q[0] | (q[1] << 8)) == 200 - (STPTLM_SIZE - 1));
+        for (i = 2; i < len; i += 11, samples++) {
+            tick = (uint16_t) (q[i] | (q[i + 1] << 8));
+            if (samples == 0)
+                tick0 = tick;
+            // motor 0 e 1 alternados em cada amostragem, sem buracos
+            CHECK((q[i + 2] & 1) == (samples & 1));
+            CHECK(tick == (uint16_t) (tick0 + samples / 2));
+            pos = (int32_t) (q[i + 3] | (q[i + 4] << 8) | (q[i + 5] << 16) | ((uint32_t) q[i + 6] << 24));
+            if ((q[i + 2] & 1) == 0) {
+                CHECK(pos >= last);		// o MOTOR1 anda, o MOTOR2 está parado
+                last = pos;
+            } else
+                CHECK(pos == 0);
+        }
+    }
+    CHECK(len == -1);
+    CHECK((samples == STPTLM_SIZE - 1) && (replies == 1) && (last > 0));
+    CHECK((Stats.TxDrops == 0) && (Stats.CrcErrors == 0));
+    n = STPTLM_GetDropped();
+    STPTLM_Stop();
+    CHECK(!(STPTLM_TIM->DIER & TIM_IT_Update) && (STPTLM_GetDropped() == n));
+    return 0;
+}
+//==============================================================================
+
+//---- Eventos descodificados pelo Tools/stptrace.c
+static TTrcEvent 	Trc[64];
+static int 			TrcN;
+
+static void __TrcKeep(const TTrcEvent *e)
+{
+    if (TrcN < 64)
+        Trc[TrcN] = *e;
+    TrcN++;
+}
+
+//==============================================================================
+//	descri:   Trace: um movimento conhecido pedido pelo STPCOM_CMD_TRACE e descodificado pelo
+//				 __TrcFrames do stptrace, eventos por ordem e com o tempo do timer certo
+//
+static int __TestTrace(void)
+{
+    // eventos esperados: tempo (0 = t0, 1 = fim da rampa, 2 = t1, 3 = paragem), evento, motor, dados
+    static const uint16_t exp[][4] = {
+        {0, trc_Micro, 0, 1}, {0, trc_Micro, 1, 1},
+        {0, trc_Cmd, 0, 400}, {0, trc_Segment, 0, 400}, {0, trc_MotorOn, 0, STPDRV_TIMFREQ / STPDRV_STARTSTOPSEC},
+        {1, trc_Done, 0, mstat_Move},
+        {2, trc_Cmd, 0, STPDRV_STARTSTOPSEC}, {2, trc_Segment, 0, STPDRV_STARTSTOPSEC},
+        {3, trc_Done, 0, mstat_Stop}, {3, trc_MotorOff, 0, 0}};
+    uint8_t p[2], raw[STPDRV_TRACE_LEN * 8];
+    mtrace_rec_t rec[STPDRV_TRACE_LEN];
+    uint32_t start;
+    uint64_t t[4];
+    uint16_t first, count, n;
+    int k;
+
+    __ComBegin();
+    CHECK(__Run(0.01, 0) == 0);
+    STPDRV_SetRamp(MOTOR1, 2000);
+    t[0] = SimNow;
+    STPDRV_Move(MOTOR1, dir_CW, 400);
+    SIM_Sync();
+    CHECK(__Run(2, __Ramp0) == 0);
+    t[1] = SimNow;
+    CHECK(__Run(0.05, 0) == 0);
+    t[2] = SimNow;
+    STPDRV_Stop(MOTOR1, 0);
+    SIM_Sync();
+    CHECK(__Run(2, __Idle0) == 0);
+    t[3] = SimNow;
+
+    start = ComOutLen;
+    first = 0;
+    do {
+        p[0] = (uint8_t) first;
+        p[1] = (uint8_t) (first >> 8);
+        CHECK(__ComCmd(STPCOM_CMD_TRACE, p, 2, 0) == STPCOM_ACK);
+        count = STPDRV_TraceCount();
+        first += STPCOM_TRACE_PERFRAME;
+    } while (first < count);
+
+    TrcN = 0;
+    TrcSink = __TrcKeep;
+    __TrcFrames(&ComOut[start], (long) (ComOutLen - start));
+    CHECK(TrcN == (int) (sizeof(exp) / sizeof(exp[0])));
+    // o primeiro evento é o do STPDRV_Init, no instante 0: os ticks descodificados são o SimNow
+    for (k = 0; k < TrcN; k++) {
+        CHECK((Trc[k].Event == exp[k][1]) && (Trc[k].Motor == exp[k][2]));
+        CHECK(Trc[k].Ticks == (exp[k][0] ? t[exp[k][0]] : (k < 2 ? 0 : t[0])));
+        CHECK((Trc[k].Event == trc_MotorOff) ? (Trc[k].Data == (uint16_t) STPDRV_GetPos(MOTOR1)) : (Trc[k].Data == exp[k][3]));
+    }
+    CHECK(NEAR(t[1] - t[0], SECS((400.0 - STPDRV_STARTSTOPSEC) / 2000)));
+
+    // os mesmos eventos em bruto (stptrace -r), copiados pelo STPDRV_TraceDump
+    n = STPDRV_TraceDump(rec, 0, STPDRV_TRACE_LEN);
+    CHECK(n == TrcN);
+    for (k = 0; k < n; k++) {
+        memcpy(&raw[k * 8], &rec[k].Time, 4);			// o PC também é little endian
+        raw[k * 8 + 4] = rec[k].Event;
+        raw[k * 8 + 5] = rec[k].Motor;
+        memcpy(&raw[k * 8 + 6], &rec[k].Data, 2);
+    }
+    TrcN = 0;
+    __TrcBegin(n);
+    for (k = 0; k < n; k++)
+        __TrcEvent(&raw[k * 8]);
+    TrcSink = __TrcPrint;
+    CHECK((TrcN == n) && (Trc[n - 1].Ticks == t[3]) && (Trc[n - 1].Event == trc_MotorOff));
+    return 0;
+}
+//==============================================================================
+
+//---- Interruptores simulados do homing, posição contada nos pinos (Net) onde fecham
+static int32_t 	SwMin[2], SwMax[2];
+static uint8_t 	HomeSeq[16];			// estados do homing do MOTOR1 por ordem, sem repetições
+static int 			HomeSeqN;
+static int32_t 	HomeLow;				// menor posição do MOTOR1 (a cada Poll e em cada flanco)
+
+//==============================================================================
+//	descri:   Nivel de um interruptor simulado
+//	return:	1 se fechado
+//
+static int __SwClosed(int mt, int sw)
+{
+    return sw ? (Net[mt] >= SwMax[mt]) : (Net[mt] <= SwMin[mt]);
+}
+//
+// condição de paragem do __Run: um interruptor mudou
+static int __SwEdge(void)
+{
+    int mt, sw;
+
+    for (mt = 0; mt < 2; mt++)
+        for (sw = 0; sw < 2; sw++)
+            if (__SwClosed(mt, sw) != __Active(mt, (uint8_t) sw))
+                return 1;
+    return 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Muda os pinos dos interruptores, no fecho chama a IRQ do EXTI
+//	return:	0 se OK
+//
+static int __SwApply(void)
+{
+    uint16_t pin;
+    int mt, sw;
+
+    for (mt = 0; mt < 2; mt++)
+        for (sw = 0; sw < 2; sw++) {
+            pin = STPHOME_PIN(Pins[mt][sw]);
+            if (__SwClosed(mt, sw) == __Active(mt, (uint8_t) sw))
+                continue;
+            if (!__SwClosed(mt, sw)) {
+                STPHOME_PORT->IDR |= pin;
+                continue;
+            }
+            STPHOME_PORT->IDR &= (uint16_t) ~pin;
+            EXTI->PR |= pin;
+            EXTI15_10_IRQHandler();
+            CHECK(EXTI->PR == pin);		// a IRQ escreveu 1 no bit que serviu (rc_w1)
+            EXTI->PR = 0;
+            SIM_Sync();
+        }
+    return 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Corre o timer com os interruptores e o STPHOME_Poll até "done"
+//	return:	0 se OK, -1 se "done" não foi atingido em "secs" segundos, 1 se a IRQ falhou
+//
+static int __HomeRun(double secs, int (*done)(void))
+{
+    uint64_t limit = SimNow + SECS(secs), poll = SimNow;
+
+    while (1) {
+        if (HomeSeq[HomeSeqN - 1] != (uint8_t) STPHOME_GetState(MOTOR1))
+            HomeSeq[HomeSeqN++ & 15] = (uint8_t) STPHOME_GetState(MOTOR1);
+        if (Net[0] < HomeLow)
+            HomeLow = Net[0];
+        if (done())
+            return 0;
+        if (SimNow >= limit)
+            return -1;
+        if (SimNow >= poll) {
+            STPHOME_Poll();
+            SIM_Sync();
+            poll += SECS(0.005);
+            continue;
+        }
+        // até ao proximo Poll ou até um interruptor mudar
+        __Run((double) (poll - SimNow) / SIM_TICKS, __SwEdge);
+        if (__SwApply())
+            return 1;
+    }
+}
+//
+static int __HomeEnd0(void)
+{
+    return STPHOME_GetState(MOTOR1) >= home_Done;
+}
+//
+static int __Stopped1(void)
+{
+    return STPDRV_GetSpeed(MOTOR2) == 0;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Homing rápido com desaceleração, recuo e aproximação lenta no MOTOR1. No MOTOR2 o
+//				 fim de curso pára pelo flanco e pelo nivel, e pode-se sempre sair dele
+//
+static int __TestHome(void)
+{
+    static const uint8_t seq[] = {home_Idle, home_Fast, home_Stopping, home_Backoff, home_Slow, home_Done};
+    stphome_cfg_t cfg = {dir_CCW, 800, 100, 20, 1000, 0};
+    int32_t pos;
+    int k;
+
+    __Begin();
+    memset(Homes, 0, sizeof(Homes));
+    memset((void *) &HostEXTI, 0, sizeof(HostEXTI));
+    STPHOME_PORT->IDR |= STPHOME_LINES;			// pull-up, todos abertos
+    SwMin[0] = -300;
+    SwMax[0] = 100000;
+    SwMin[1] = -100000;
+    SwMax[1] = 300;
+    STPHOME_Init();
+    CHECK((EXTI->IMR & STPHOME_LINES) == STPHOME_LINES);
+    EXTI->PR = 0;									// o Init escreveu 1 para apagar (rc_w1)
+    STPDRV_SetRamp(MOTOR1, 4000);
+    STPDRV_SetRamp(MOTOR2, 4000);
+    STPHOME_Config(MOTOR1, &cfg);
+
+    HomeSeq[0] = home_Idle;
+    HomeSeqN = 1;
+    HomeLow = 0;
+    CHECK(STPHOME_Start(MOTOR1) == 1);
+    SIM_Sync();
+    CHECK(STPHOME_Start(MOTOR1) == 0);
+    CHECK(__HomeRun(5, __HomeEnd0) == 0);
+    CHECK(HomeSeqN == (int) sizeof(seq));
+    for (k = 0; k < HomeSeqN; k++)
+        CHECK(HomeSeq[k] == seq[k]);
+    // a aproximação rápida desacelera para lá do interruptor, a lenta pára no flanco
+    CHECK(HomeLow < SwMin[0] - 10);
+    CHECK((STPHOME_GetLimits(MOTOR1, &pos) == 0) && (pos == SwMin[0]));
+    CHECK((Net[0] == SwMin[0]) && (STPDRV_GetPos(MOTOR1) == cfg.Offset));
+    CHECK(STPDRV_GetSpeed(MOTOR1) == 0);
+
+    // fim de curso MAX do MOTOR2: o flanco pára o motor no ponto do fecho
+    STPDRV_Move(MOTOR2, dir_CW, 400);
+    SIM_Sync();
+    CHECK(__HomeRun(2, __Stopped1) == 0);
+    CHECK((STPHOME_GetLimits(MOTOR2, &pos) == STPHOME_LIM_MAX) && (pos == SwMax[1]));
+    CHECK(Net[1] == SwMax[1]);
+
+    // com o interruptor fechado não há flanco, o nivel no STPHOME_Poll pára o motor
+    STPHOME_ClearLimits(MOTOR2);
+    STPDRV_Move(MOTOR2, dir_CW, 400);
+    SIM_Sync();
+    CHECK(__HomeRun(1, __Stopped1) == 0);
+    CHECK(STPHOME_GetLimits(MOTOR2, 0) == STPHOME_LIM_MAX);
+    CHECK(Net[1] <= SwMax[1] + 400 * 5 / 1000 + 2);
+
+    // na direcção contrária sai sempre do fim de curso
+    STPHOME_ClearLimits(MOTOR2);
+    STPDRV_Move(MOTOR2, dir_CCW, 400);
+    SIM_Sync();
+    CHECK(__HomeRun(0.5, __Stopped1) == -1);
+    CHECK((STPDRV_GetSpeed(MOTOR2) != 0) && (Net[1] < SwMax[1] - 50));
+    CHECK((STPHOME_GetLimits(MOTOR2, 0) == 0) && !__Active(MOTOR2, 1));
+    return 0;
+}
+//==============================================================================
+
+//---- Tarefas do teste do scheduler
+static int16_t 	SchId;
+static uint32_t 	SchCalls, SchOnce, SchAgain, SchErr;
+
+//==============================================================================
+//	descri:   SysTick no ciclo "cyc" desde o STPSCH_Init, a IRQ só corre "lat" ciclos depois do
+//				 reload
+//
+static void __SysTickAt(uint64_t cyc, uint32_t lat)
+{
+    uint32_t n = SysTick->LOAD + 1, ph = (uint32_t) (cyc % n);
+
+    SysTick->VAL = SysTick->LOAD - ph;
+    Ticks = (uint32_t) (cyc / n);
+    SCB->ICSR = 0;
+    if ((ph < lat) && (cyc >= n)) {
+        Ticks--;
+        SCB->ICSR = SCB_ICSR_PENDSTSET_Msk;
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Tarefa periódica que se remove à terceira execução
+//
+static void __SchSelf(void)
+{
+    if (++SchCalls == 3)
+        STPSCH_Remove(SchId);
+}
+//
+static void __SchOnce(void)
+{
+    SchOnce++;
+}
+//
+// one-shot que se adiciona de novo uma vez
+static void __SchAgain(void)
+{
+    if ((++SchAgain == 1) && (STPSCH_Add(__SchAgain, 5, 0) < 0))
+        SchErr++;
+}
+//==============================================================================
+
+//==============================================================================
+//
+static int __TestSched(void)
+{
+    uint64_t cyc, c0;
+    uint32_t us = 0, prev, n;
+    int16_t i;
+
+    SchCalls = SchOnce = SchAgain = SchErr = 0;
+    STPSCH_Init();
+    CHECK(SysTick->LOAD == SystemCoreClock / STPSCH_TICKFREQ - 1);
+    n = SysTick->LOAD + 1;
+
+    // Micros igual ao tempo real em todos os ciclos de 3 reloads, com a IRQ do SysTick atrasada
+    // 50 us, e também onde o ms * 1000 dá a volta aos 32 bits
+    for (c0 = 10 * (uint64_t) n; c0 <= 4294966 * (uint64_t) n; c0 += 4294956 * (uint64_t) n) {
+        __SysTickAt(c0 - 1, 1200);
+        prev = STPSCH_Micros();
+        for (cyc = c0; cyc < c0 + 3 * (uint64_t) n; cyc++) {
+            __SysTickAt(cyc, 1200);
+            us = STPSCH_Micros();
+            CHECK(us == (uint32_t) (cyc * 1000000 / SystemCoreClock));
+            CHECK(us - prev <= 1);
+            prev = us;
+        }
+    }
+    CHECK(us == (uint32_t) (4294969 * (uint64_t) 1000 - 1));
+
+    // periódica que se remove dentro dela, a entrada fica livre
+    STPSCH_Init();
+    SchId = STPSCH_Add(__SchSelf, 0, 10);
+    CHECK(SchId == 0);
+    for (Ticks = 0; Ticks < 100; Ticks++)
+        __RunDue(Ticks);
+    CHECK((SchCalls == 3) && (Tasks[SchId].Task == 0) && (STPSCH_GetLate() == 0));
+    CHECK(STPSCH_Add(__SchOnce, 0, 0) == SchId);
+    STPSCH_Remove(SchId);
+
+    // one-shot com atraso corre uma vez no seu tick, a que se adiciona de novo corre 2 vezes
+    Ticks = 1000;
+    CHECK(STPSCH_Add(__SchOnce, 7, 0) >= 0);
+    CHECK(STPSCH_Add(__SchAgain, 3, 0) >= 0);
+    for (; Ticks < 1007; Ticks++)
+        __RunDue(Ticks);
+    CHECK((SchOnce == 0) && (SchAgain == 1) && !SchErr);
+    CHECK(__RunDue(Ticks) && (SchOnce == 1));
+    for (Ticks++; Ticks < 1100; Ticks++)
+        __RunDue(Ticks);
+    CHECK((SchOnce == 1) && (SchAgain == 2) && (STPSCH_GetLate() == 0));
+    for (i = 0; i < STPSCH_MAXTASKS; i++)
+        CHECK(Tasks[i].Task == 0);
+
+    // periódica atrasada 35 ms: corre uma vez, não recupera as execuções perdidas
+    SchCalls = 0;
+    SchId = STPSCH_Add(__SchSelf, 0, 10);
+    __RunDue(Ticks);
+    Ticks += 35;
+    CHECK(__RunDue(Ticks) && (SchCalls == 2) && (STPSCH_GetLate() == 25));
+    CHECK(!__RunDue(Ticks) && (Tasks[SchId].Next == Ticks + 10));
+    STPSCH_Remove(SchId);
+    return 0;
+}
+//==============================================================================
+
+//---- Lista dos testes
+static const struct {
+    const char	*Name;
+    int 			(*Fn)(void);
+} Tests[] = {
+    {"ramp", 	__TestRamp},
+    {"band", 	__TestBand},
+    {"bandslow",	__TestBandSlow},
+    {"shaper",	__TestShaper},
+    {"shaperrev",	__TestShaperRev},
+    {"micro",		__TestMicro},
+    {"inject",	__TestInject},
+    {"arc", 		__TestArc},
+    {"record", 	__TestRecord},
+    {"com", 		__TestCom},
+    {"comwrap",	__TestComWrap},
+    {"tlm", 		__TestTlm},
+    {"sched", 	__TestSched},
+    {"trace", 	__TestTrace},
+    {"home", 		__TestHome},
+};
+
+//==============================================================================
+//
+int main(int argc, char **argv)
+{
+    unsigned k;
+    int a, run, err = 0;
+
+    for (k = 0; k < sizeof(Tests) / sizeof(Tests[0]); k++) {
+        for (run = (argc < 2), a = 1; !run && (a < argc); a++)
+            run = !strcmp(argv[a], Tests[k].Name);
+        if (!run)
+            continue;
+        if (Tests[k].Fn()) {
+            printf("%-10s FALHOU\n", Tests[k].Name);
+            err = 1;
+        } else
+            printf("%-10s ok\n", Tests[k].Name);
+    }
+    return err;
+}
+//==============================================================================
+
+//=============================================================================
+// EOF stptest.c
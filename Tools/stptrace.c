@@ -0,0 +1,261 @@
+/*=============================================================================
+
+    @file    stptrace.c
+   @author  STM32StepperDriver contributors
+   @version V1.0.0
+   @date    19/10/2026
+   @brief   Host decoder for the STM32F Stepper Driver event trace
+
+   This Software is released under no garanty.
+    You may use this software for personal use.
+    Use for commercial and/or profit applications is strictly prohibited.
+
+    COPYRIGHT (C) 2026 STM32StepperDriver contributors
+
+   ===================================================================
+	                    Description (in portuguese)
+   ===================================================================
+	Converte o trace do driver (STPDRV_USE_TRACE) numa timeline legivel. Corre no PC.
+
+	Compilar:	gcc -std=c99 -O2 -o stptrace stptrace.c
+
+	Usar:		stptrace [-c clock] [-r] ficheiro
+
+		-c clock	frequência do CPU em Hz (SystemCoreClock), por defeito 24000000
+		-r			o ficheiro tem os eventos em bruto (8 bytes cada, como em mtrace_rec_t, little
+					endian), por exemplo copiados com STPDRV_TraceDump(...) e gravados pelo debugger.
+					Sem -r o ficheiro é uma captura da porta série com as respostas ao
+					STPCOM_CMD_TRACE, os outros frames e o lixo entre frames são ignorados
+
+	Cada dump (resposta com first = 0) começa uma nova timeline. O driver marca os eventos com o
+	contador de ciclos do DWT (32 bits numa leitura, o CNT do STPDRV_TIM tem 16 bits e dá a volta
+	em 0.33 s), aqui os ciclos são convertidos em ticks do STPDRV_TIM (2 * STPDRV_TIMFREQ por
+	segundo) para comparar com os delays dos eventos. O CYCCNT dá a volta ao fim de 2^32 ciclos
+	(179 segundos a 24MHz), intervalos maiores entre eventos não são detectados.
+
+	O Tools/stptest.c inclui este ficheiro com STPTRACE_NOMAIN e usa o __TrcEvent com o seu
+	TrcSink para verificar a descodificação.
+
+==============================================================================*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+//---- Iguais a mtrace_t e STPCOM_xxx em Source/stm32f_stpdrv.h e Source/stm32f_stpcom.h
+#define TRC_CMD			1
+#define TRC_SEGMENT		2
+#define TRC_DONE			3
+#define TRC_DIRFLIP		4
+#define TRC_MOTORON		5
+#define TRC_MOTOROFF		6
+#define TRC_LATE			7
+#define TRC_MICRO			8
+
+#ifndef __stm32f_stpcom_h				// já definidos quando incluido no Tools/stptest.c
+#define STPCOM_SYNC				0xA5
+#define STPCOM_CMD_TRACE		0x06
+#define STPCOM_REPLY				0x80
+#define STPDRV_TIMFREQ			100000		// ticks do timer do STEP por meio periodo (ver STPDRV_TIMFREQ)
+#endif
+
+//---- Evento descodificado
+typedef struct {
+    uint64_t	Cycles;			// ciclos desde o primeiro evento da timeline (volta do CYCCNT desdobrada)
+    uint64_t	Ticks;			// o mesmo em ticks do STPDRV_TIM
+    double		Dt;				// microsegundos desde o evento anterior
+    uint8_t		Event;
+    uint8_t		Motor;
+    uint16_t	Data;
+} TTrcEvent;
+
+static const char *Events[] = {"?", "cmd", "segment", "done", "dirflip", "motor_on", "motor_off", "LATE", "micro"};
+static const char *States[] = {"stop", "move", "goto", "arc"};
+
+static double 		Clock = 24000000.0;
+static uint64_t 	T0, TLast;
+static uint32_t 	Prev;
+static int 			Started;
+
+static void __TrcPrint(const TTrcEvent *e);
+static void (*TrcSink)(const TTrcEvent *e) = __TrcPrint;		// recebe cada evento descodificado
+
+//==============================================================================
+//	descri:   CRC16 CCITT igual ao do stm32f_stpcom.c
+//
+static uint16_t __Crc16(const uint8_t *p, int len)
+{
+    uint16_t crc = 0xFFFF;
+    int k;
+
+    while (len--) {
+        crc ^= (uint16_t) (*p++ << 8);
+        for (k = 0; k < 8; k++)
+            crc = (crc & 0x8000) ? (uint16_t) ((crc << 1) ^ 0x1021) : (uint16_t) (crc << 1);
+    }
+    return crc;
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Começa uma timeline nova
+//
+static void __TrcBegin(int count)
+{
+    Started = 0;
+    if (TrcSink != __TrcPrint)
+        return;
+    printf("\n---- trace dump");
+    if (count >= 0)
+        printf(", %d eventos", count);
+    printf("\n%12s %10s %10s  %-5s %-10s %s\n", "t(us)", "dt(us)", "tick", "motor", "evento", "dados");
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Descodifica um evento (8 bytes little endian) e passa-o ao TrcSink
+//
+static void __TrcEvent(const uint8_t *r)
+{
+    uint32_t time = (uint32_t) r[0] | ((uint32_t) r[1] << 8) | ((uint32_t) r[2] << 16) | ((uint32_t) r[3] << 24);
+    uint64_t t;
+    TTrcEvent e;
+
+    if (!Started) {
+        T0 = TLast = time;
+        Prev = time;
+        Started = 1;
+    }
+    t = TLast + (uint32_t) (time - Prev);		// desdobra a volta do CYCCNT
+    e.Cycles = t - T0;
+    e.Ticks = (uint64_t) ((double) e.Cycles * 2.0 * STPDRV_TIMFREQ / Clock + 0.5);
+    e.Dt = (double) (t - TLast) * 1e6 / Clock;
+    e.Event = r[4];
+    e.Motor = r[5];
+    e.Data = (uint16_t) (r[6] | (r[7] << 8));
+    TLast = t;
+    Prev = time;
+    TrcSink(&e);
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Imprime um evento
+//
+static void __TrcPrint(const TTrcEvent *e)
+{
+    uint8_t ev = e->Event;
+    uint16_t data = e->Data;
+
+    printf("%12.1f %10.1f %10llu  M%-4d %-10s ", (double) e->Cycles * 1e6 / Clock, e->Dt,
+           (unsigned long long) e->Ticks, e->Motor + 1, Events[ev < 9 ? ev : 0]);
+
+    switch (ev) {
+    case TRC_CMD:
+    case TRC_SEGMENT:
+        printf("%u steps/s\n", data);
+        break;
+    case TRC_DONE:
+        printf("%s\n", data < 4 ? States[data] : "?");
+        break;
+    case TRC_DIRFLIP:
+        printf("%s\n", data ? "CCW" : "CW");
+        break;
+    case TRC_MOTORON:
+        printf("delay %u (%u steps/s)\n", data, data ? STPDRV_TIMFREQ / data : 0);
+        break;
+    case TRC_MOTOROFF:
+        printf("pos & 0xFFFF = %u\n", data);
+        break;
+    case TRC_LATE:
+        printf("%u ticks depois do compare\n", data);
+        break;
+    case TRC_MICRO:
+        printf("1 STEP = %u microsteps\n", data);
+        break;
+    default:
+        printf("0x%04X\n", data);
+        break;
+    }
+}
+//==============================================================================
+
+//==============================================================================
+//	descri:   Procura as respostas ao STPCOM_CMD_TRACE numa captura da porta série
+//
+static void __TrcFrames(const uint8_t *b, long n)
+{
+    long i = 0;
+    int len, k, first;
+
+    while (i + 5 <= n) {
+        len = b[i + 1];
+        if ((b[i] != STPCOM_SYNC) || (i + len + 5 > n) ||
+            (__Crc16(&b[i + 1], len + 2) != (uint16_t) (b[i + len + 3] | (b[i + len + 4] << 8)))) {
+            i++;
+            continue;
+        }
+        // reply: status, first u16, count u16, eventos
+        if ((b[i + 2] == (STPCOM_CMD_TRACE | STPCOM_REPLY)) && (len >= 5) && (b[i + 3] == 0)) {
+            first = b[i + 4] | (b[i + 5] << 8);
+            if (first == 0)
+                __TrcBegin(b[i + 6] | (b[i + 7] << 8));
+            for (k = 5; k + 8 <= len; k += 8)
+                __TrcEvent(&b[i + 3 + k]);
+        }
+        i += len + 5;
+    }
+}
+//==============================================================================
+
+#ifndef STPTRACE_NOMAIN
+//==============================================================================
+//
+int main(int argc, char **argv)
+{
+    FILE *f;
+    uint8_t *buf;
+    long n, k;
+    int raw = 0, a;
+
+    for (a = 1; (a < argc) && (argv[a][0] == '-'); a++) {
+        if (!strcmp(argv[a], "-r"))
+            raw = 1;
+        else if (!strcmp(argv[a], "-c") && (a + 1 < argc))
+            Clock = atof(argv[++a]);
+        else
+            break;
+    }
+    if ((a != argc - 1) || (Clock <= 0)) {
+        fprintf(stderr, "usage: %s [-c clock] [-r] file\n", argv[0]);
+        return 1;
+    }
+    if ((f = fopen(argv[a], "rb")) == NULL) {
+        perror(argv[a]);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    buf = malloc(n ? n : 1);
+    if ((buf == NULL) || (fread(buf, 1, n, f) != (size_t) n)) {
+        fprintf(stderr, "%s: read error\n", argv[a]);
+        return 1;
+    }
+    fclose(f);
+
+    if (raw) {
+        __TrcBegin(n / 8);
+        for (k = 0; k + 8 <= n; k += 8)
+            __TrcEvent(&buf[k]);
+    } else
+        __TrcFrames(buf, n);
+
+    free(buf);
+    return 0;
+}
+//==============================================================================
+#endif
+
+//=============================================================================
+// EOF stptrace.c